@@ -0,0 +1,98 @@
+#ifndef ASYNC_SERVICE_CALLER_H
+#define ASYNC_SERVICE_CALLER_H
+
+#include <ros/ros.h>
+#include <deque>
+#include <utility>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace grasping_experiments
+{
+  //-----------------------------------------------------------
+  ///**Handle to a service call queued on an AsyncServiceCaller. Copies share the same call. A default constructed future is invalid and never becomes ready.*/
+  class ServiceCallFuture
+  {
+  public:
+
+    ServiceCallFuture() {}
+
+    bool valid() const;
+    //**Whether the call returned*/
+    bool ready() const;
+    /**Waits until the call returned, at most timeout seconds (timeout <= 0: no limit). Returns false if the call failed, did not
+     * return in time or the future is invalid. A timed out call can't be cancelled, it keeps running in its worker.*/
+    bool wait(double timeout) const;
+    //**Wall time from dequeueing the call until it returned, 0 if it isn't ready*/
+    double duration() const;
+
+  private:
+
+    friend class AsyncServiceCaller;
+
+    struct State
+    {
+      State() : done_(false), success_(false), duration_(0.0) {}
+
+      boost::mutex m_;
+      boost::condition_variable cond_;
+      bool done_;
+      bool success_;
+      double duration_;
+    };
+
+    void finish(bool success, double duration);
+
+    boost::shared_ptr<State> state_;
+  };
+  //-----------------------------------------------------------
+  ///**A small pool of worker threads which runs blocking ros::ServiceClient calls, so that independent calls can overlap.*/
+  class AsyncServiceCaller
+  {
+  public:
+
+    AsyncServiceCaller();
+    //**Fails all calls which are still queued and joins the workers (after their current call returned)*/
+    ~AsyncServiceCaller();
+
+    //**Starts n_workers threads, calls queued before are run once the workers are up*/
+    void start(unsigned int n_workers);
+
+    /**Queues client.call(*srv), client is a ros::ServiceClient or a PooledServiceClient. srv is shared with the worker and
+     * must not be accessed before the returned future is ready. Checking the response (e.g., a success flag) is up to the caller.*/
+    template<class Client, class Service>
+    ServiceCallFuture call(Client const& client, boost::shared_ptr<Service> const& srv)
+    {
+      return run(boost::bind(&AsyncServiceCaller::callService<Client, Service>, client, srv));
+    }
+
+    //**Queues an arbitrary blocking job, e.g., a method which makes a call and checks its response. A job which throws fails its future*/
+    ServiceCallFuture run(boost::function<bool()> const& job);
+
+    //**A future which is ready already, e.g., for calls which are skipped in simulation*/
+    static ServiceCallFuture completed(bool success);
+
+  private:
+
+    template<class Client, class Service>
+    static bool callService(Client client, boost::shared_ptr<Service> srv)
+    {
+      return client.call(*srv);
+    }
+
+    void work();
+
+    boost::mutex m_;
+    boost::condition_variable cond_;
+    bool stop_;
+    std::deque<std::pair<boost::function<bool()>, ServiceCallFuture> > jobs_;
+    boost::thread_group workers_;
+  };
+
+}//end namespace grasping_experiments
+
+#endif
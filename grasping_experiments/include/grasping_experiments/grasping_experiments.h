@@ -14,6 +14,10 @@
 #include <lbr_fri/SetStiffness.h>
 #include <sensor_msgs/JointState.h>
 #include <controller_manager_msgs/SwitchController.h>
+#include <grasping_experiments/phase_graph.h>
+#include <grasping_experiments/async_service_caller.h>
+#include <grasping_experiments/replace_tasks.h>
+#include <grasping_experiments/service_client_pool.h>
 
 namespace grasping_experiments
 {
@@ -64,6 +68,18 @@ namespace grasping_experiments
 
     std::vector<double> joints_; //pre-place joint values
   };
+  //-----------------------------------------------------------
+  ///**The tasks of a phase, built but not yet sent. Applying the set only takes the set_tasks call, so it can be built ahead while the previous phase is still converging.*/
+  struct PhaseTaskSet
+  {
+    PhaseTaskSet() : phase_(-1), build_time_(0.0) {}
+
+    hqp_controllers_msgs::SetTasks tasks_;
+    std::vector<unsigned int> monitored_; ///< indices in tasks_.request.tasks of the tasks whose completion ends the phase
+    std::vector<unsigned int> visualized_; ///< indices in tasks_.request.tasks of the tasks shown in Rviz
+    int phase_; ///< index of the phase the set was built for, -1 if empty
+    double build_time_; ///< wall time it took to build the set
+  };
   ////-----------------------------------------------------------
   //struct CartesianStiffness
   //{
@@ -94,6 +110,8 @@ namespace grasping_experiments
     bool task_status_changed_;
     bool task_success_;
     bool with_gazebo_; ///<indicate whether the node is run in simulation
+    bool pipeline_transitions_; ///< build the tasks of the next phase while the current one converges
+    double service_timeout_; ///< maximum time to wait for an asynchronous service call [s]
     std::vector<unsigned int> pers_task_vis_ids_; ///< indicates which persistent tasks (the ones which are loaded) should always be visualized
 
     //**Grasp definition - this should be modified to grasp different objects */
@@ -103,37 +121,42 @@ namespace grasping_experiments
 
     ros::Subscriber task_status_sub_;
     ros::Subscriber joint_state_sub_;
-
-    ros::ServiceClient set_tasks_clt_;
-    ros::ServiceClient get_grasp_interval_clt_;
-    ros::ServiceClient activate_hqp_control_clt_;
-    ros::ServiceClient set_task_objects_clt_;
-    ros::ServiceClient visualize_task_geometries_clt_;
-    ros::ServiceClient remove_tasks_clt_;
-    ros::ServiceClient set_gazebo_physics_clt_;
-    ros::ServiceClient velvet_pos_clt_;
-    ros::ServiceClient load_tasks_clt_;
-    ros::ServiceClient reset_hqp_control_clt_;
-    ros::ServiceClient velvet_grasp_clt_;
-    ros::ServiceClient set_stiffness_clt_;
-    ros::ServiceClient next_truck_task_clt_;
-    ros::ServiceServer start_demo_srv_;
-    ros::ServiceServer gimme_beer_srv_;
-    ros::ServiceServer lets_dance_srv_;
-    ros::ServiceServer look_what_i_found_srv_;
-
-    ros::ServiceClient switch_controller_clt_;
+    ros::Publisher diagnostics_pub_;
+    ros::WallTimer diagnostics_timer_;
+
+    ServiceClientPool service_pool_; ///< creates the service clients below and collects their latencies
+
+    PooledServiceClient set_tasks_clt_;
+    PooledServiceClient get_grasp_interval_clt_;
+    PooledServiceClient activate_hqp_control_clt_;
+    PooledServiceClient set_task_objects_clt_;
+    PooledServiceClient visualize_task_geometries_clt_;
+    PooledServiceClient remove_tasks_clt_;
+    PooledServiceClient set_gazebo_physics_clt_;
+    PooledServiceClient velvet_pos_clt_;
+    PooledServiceClient load_tasks_clt_;
+    PooledServiceClient reset_hqp_control_clt_;
+    PooledServiceClient velvet_grasp_clt_;
+    PooledServiceClient set_stiffness_clt_;
+    PooledServiceClient next_truck_task_clt_;
+    std::vector<ros::ServiceServer> phase_graph_srvs_; ///< one service per phase graph, named as the graph, including the invalid ones
+
+    PooledServiceClient switch_controller_clt_;
+    ReplaceTasksClient replace_tasks_; ///< runs phase transitions as one transaction if the controller (or an adapter) supports it
 
     //** Manipulator joint configuration while moving the forklift */
     std::vector<double> transfer_config_;
     //** Manipulator joint configuration prior to reach-to-grasp */
     std::vector<double> sensing_config_;
     std::vector<double> gimme_beer_config_;
-    std::vector<double> look_beer_config_;
+    //** Demo sequences, loaded from the parameter server at startup */
+    std::vector<PhaseGraph> phase_graphs_;
     //** message holding the active tasks at each state. After each state change these tasks are removed and replaced by the ones corresponding to the next state. */
     hqp_controllers_msgs::SetTasks tasks_;
     //** map holding the ids of those tasks whose completion indicates a state change*/
     std::vector<unsigned int> monitored_tasks_;
+    //** runs the service calls which can overlap with others - declared last, so its workers are joined before the clients they use are destroyed*/
+    AsyncServiceCaller async_;
 
 
     //** To be called before entering a new state*/
@@ -151,14 +174,36 @@ namespace grasping_experiments
     //**First deactivates the HQP control scheme (the controller will output zero velocity commands afterwards) and then calls a ros::shutdown */
     void safeShutdown();
 
-    bool setJointConfiguration(std::vector<double> const& joints);
-    bool setGraspApproach();
-    bool setObjectExtract();
-    bool setGripperExtract(PlaceInterval const& place);
-    bool setObjectPlace(PlaceInterval const& place);
+    bool buildJointConfiguration(std::vector<double> const& joints, PhaseTaskSet& set);
+    bool buildGraspApproach(PhaseTaskSet& set);
+    bool buildObjectExtract(PhaseTaskSet& set);
+    bool buildGripperExtract(PlaceInterval const& place, PhaseTaskSet& set);
+    bool buildObjectPlace(PlaceInterval const& place, PhaseTaskSet& set);
+    bool buildCustomTasks(TaskTemplate const& task_template, PhaseTaskSet& set);
+    //** sends the tasks of set to the controller and monitors them*/
+    bool applyPhaseTasks(PhaseTaskSet const& set);
+    //** replaces the tasks of the controller by the ones of set in one transaction (deactivate, remove, set, activate, visualize), activation waits for the stiffness change*/
+    bool replaceStateTasks(PhaseTaskSet const& set, ServiceCallFuture const& stiffness);
+    //** returns the ids of the applied tasks of set which should be visualized, together with the persistent ones*/
+    std::vector<unsigned int> phaseVisualizationIds(PhaseTaskSet const& set) const;
     bool loadPersistentTasks();
     bool getGraspInterval();
     bool setCartesianStiffness(double sx, double sy, double sz, double sa, double sb, double sc);
+    //** sets the stiffness of a phase (if any) on the worker pool*/
+    ServiceCallFuture setCartesianStiffnessAsync(std::vector<double> const& stiffness);
+    //** moves the velvet gripper on the worker pool (does nothing in Gazebo)*/
+    ServiceCallFuture moveGripperAsync(double angle);
+
+    //** Builds the tasks of phase p of graph g into set*/
+    bool buildPhaseTasks(PhaseGraph const& g, int p, PhaseTaskSet& set);
+    //** Whether the tasks of a phase can be built before the phase is entered (i.e., they don't depend on a sensor query)*/
+    bool canPrebuild(Phase const& phase) const;
+    //** Runs TASKS phase p of graph g until its monitored tasks are completed, active is set to the time the HQP control was activated. next holds the tasks pre-built for this phase (if next.phase_ == p) and is refilled with the tasks of the following TASKS phase while this one converges. stiffness is the pending stiffness change of the phase, which has to complete before the control is activated. saved is set to the dead time which was moved off the transition.*/
+    bool executeTaskPhase(PhaseGraph const& g, int p, std::vector<unsigned int> const& loops, PhaseTaskSet& next, ServiceCallFuture const& stiffness, ros::WallTime& active, double& saved);
+    //** Runs a phase which doesn't set HQP tasks (gripper, controller switch, truck, reset)*/
+    bool executeActionPhase(Phase const& phase);
+    //** Prints the accumulated timing of each phase of the graph*/
+    void reportPhaseTiming(PhaseGraph const& graph);
 
     //double maximumNorm(std::vector<double>const& e);
 
@@ -170,10 +215,12 @@ namespace grasping_experiments
 
     void taskStatusCallback(const hqp_controllers_msgs::TaskStatusArrayPtr& msg);
     void jointStateCallback(const sensor_msgs::JointStatePtr& msg);
-    bool startDemo(std_srvs::Empty::Request  &req,std_srvs::Empty::Response &res );
-    bool gimmeBeer(std_srvs::Empty::Request  &req,std_srvs::Empty::Response &res );
-    bool letsDance(std_srvs::Empty::Request  &req,std_srvs::Empty::Response &res );
-    bool lookWhatIFound(std_srvs::Empty::Request  &req,std_srvs::Empty::Response &res );
+    //** publishes the latency statistics of the service clients*/
+    void publishDiagnostics(const ros::WallTimerEvent& event);
+    //** Runs phase_graphs_[graph] from its first phase*/
+    bool runPhaseGraph(std_srvs::Empty::Request  &req,std_srvs::Empty::Response &res, unsigned int graph);
+    //** Service of a phase graph which failed to load, only reports the error*/
+    bool rejectPhaseGraph(std_srvs::Empty::Request  &req,std_srvs::Empty::Response &res, const std::string& graph);
   };
 
 }//end namespace hqp controllers
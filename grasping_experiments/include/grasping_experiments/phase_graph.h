@@ -0,0 +1,96 @@
+#ifndef PHASE_GRAPH_H
+#define PHASE_GRAPH_H
+
+#include <ros/ros.h>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <string>
+#include <hqp_controllers_msgs/Task.h>
+
+namespace grasping_experiments
+{
+  //-----------------------------------------------------------
+#define PHASE_END   -1 ///< transition target which finishes the graph successfully
+#define PHASE_ABORT -2 ///< transition target which stops the HQP control and shuts the node down
+  //-----------------------------------------------------------
+  ///**Describes the HQP tasks of a phase. All parameters are resolved when the graph is loaded, only the grasp interval can change at runtime.*/
+  struct TaskTemplate
+  {
+    enum Type { JOINT_CONFIGURATION, GRASP_APPROACH, OBJECT_EXTRACT, OBJECT_PLACE, GRIPPER_EXTRACT, CUSTOM };
+
+    Type type_;
+    std::vector<double> joints_; ///< JOINT_CONFIGURATION
+    unsigned int place_zone_; ///< OBJECT_PLACE, GRIPPER_EXTRACT
+    bool query_grasp_interval_; ///< GRASP_APPROACH - ask the get_grasp_interval service before building the tasks (real robot only)
+    std::vector<hqp_controllers_msgs::Task> tasks_; ///< CUSTOM
+    std::vector<unsigned int> monitored_; ///< CUSTOM - indices in tasks_ of the tasks whose completion ends the phase
+  };
+  //-----------------------------------------------------------
+  struct Phase
+  {
+    enum Type { TASKS, GRIPPER_POSITION, GRIPPER_GRASP, SWITCH_CONTROLLERS, TRUCK_TASK, RESET };
+
+    std::string name_;
+    Type type_;
+
+    TaskTemplate template_; ///< TASKS
+    double task_error_tol_; ///< TASKS - the phase is completed once the maximum error of the monitored tasks is below
+    double task_diff_tol_; ///< TASKS - the phase is completed if the task progress stagnates below this difference for task_timeout_tol_
+
+    std::vector<double> stiffness_; ///< cartesian stiffness set at the start of the phase (sx, sy, sz, sa, sb, sc), empty to keep the current one
+    double gripper_angle_; ///< GRIPPER_POSITION
+    bool background_; ///< GRIPPER_POSITION - don't wait for the gripper, the next gripper phase or the end of the graph does
+    std::vector<std::string> start_controllers_; ///< SWITCH_CONTROLLERS
+    std::vector<std::string> stop_controllers_; ///< SWITCH_CONTROLLERS
+
+    int next_; ///< phase index, PHASE_END or PHASE_ABORT
+    int on_failure_; ///< phase index, PHASE_END or PHASE_ABORT
+    int loop_to_; ///< if >= 0, go back to this phase loop_count_ - 1 times before following next_
+    unsigned int loop_count_;
+  };
+  //-----------------------------------------------------------
+  ///**Accumulated timing of a phase over all runs of its graph. The setup time spans from entering the phase until the HQP control is active again (i.e., the dead time of the transition), the convergence time from there until the phase is completed. Action phases only have a setup time. The saved time is the work (building and visualizing the tasks) which was pipelined out of the transition.*/
+  struct PhaseTiming
+  {
+    PhaseTiming() : count_(0), setup_sum_(0.0), setup_max_(0.0), convergence_sum_(0.0), convergence_max_(0.0), saved_sum_(0.0), saved_max_(0.0) {}
+
+    void record(double setup, double convergence, double saved)
+    {
+      count_++;
+      setup_sum_ += setup;
+      setup_max_ = std::max(setup_max_, setup);
+      convergence_sum_ += convergence;
+      convergence_max_ = std::max(convergence_max_, convergence);
+      saved_sum_ += saved;
+      saved_max_ = std::max(saved_max_, saved);
+    }
+
+    unsigned int count_;
+    double setup_sum_, setup_max_;
+    double convergence_sum_, convergence_max_;
+    double saved_sum_, saved_max_;
+  };
+  //-----------------------------------------------------------
+  struct PhaseGraph
+  {
+    std::string name_;
+    std::vector<Phase> phases_; ///< the graph starts with the first phase
+    std::vector<PhaseTiming> timing_; ///< one per phase
+  };
+  //-----------------------------------------------------------
+  /**Returns the phase which follows phase p of graph g when p completed successfully (a phase index, PHASE_END or PHASE_ABORT). loops holds the completed passes of each loop and is updated.*/
+  int successorPhase(PhaseGraph const& g, int p, std::vector<unsigned int>& loops);
+  //-----------------------------------------------------------
+  /**Reads all graphs from the "phase_graphs" map of n and checks them completely, so that running a graph can't fail
+   * on its description. joint_configurations holds the built-in named configurations which JOINT_CONFIGURATION phases can
+   * refer to, they are extended/overridden by the "joint_configurations" map of n. place_zone_joints holds the pre-place
+   * configurations of the place zones. Graphs with errors are skipped (with an error message) and their names are returned
+   * in invalid_graphs, returns false if none could be loaded.*/
+  bool loadPhaseGraphs(const ros::NodeHandle& n, const std::map<std::string, std::vector<double> >& joint_configurations,
+                       const std::vector<std::vector<double> >& place_zone_joints, unsigned int n_joints, std::vector<PhaseGraph>& graphs,
+                       std::vector<std::string>& invalid_graphs);
+
+}//end namespace grasping_experiments
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef REPLACE_TASKS_H
+#define REPLACE_TASKS_H
+
+#include <ros/ros.h>
+#include <grasping_experiments/ReplaceTasks.h>
+#include <grasping_experiments/service_client_pool.h>
+
+namespace grasping_experiments
+{
+  //-----------------------------------------------------------
+  ///**The single HQP controller services which make up a replace_tasks transaction*/
+  struct HQPControlClients
+  {
+    PooledServiceClient activate_hqp_control_;
+    PooledServiceClient remove_tasks_;
+    PooledServiceClient set_tasks_;
+    PooledServiceClient visualize_task_geometries_;
+
+    //**Creates the clients for activate_hqp_control, remove_tasks, set_tasks and visualize_task_geometries in n from pool*/
+    void init(ServiceClientPool& pool, ros::NodeHandle& n);
+  };
+  //-----------------------------------------------------------
+  /**Runs the steps of a replace_tasks transaction as single calls, in the order given in ReplaceTasks.srv. Stops at the first
+   * failing step and returns res.success.*/
+  bool replayReplaceTasks(HQPControlClients& clients, ReplaceTasks::Request const& req, ReplaceTasks::Response& res);
+  //-----------------------------------------------------------
+  ///**Client side of replace_tasks transactions. A transaction is sent in one request if a replace_tasks service exists (offered by the HQP controller or by a replace_tasks_adapter node), otherwise its steps are replayed as single calls.*/
+  class ReplaceTasksClient
+  {
+  public:
+
+    ReplaceTasksClient() : batched_(false) {}
+
+    //**Creates the clients in n from pool. If batch is set, waits up to timeout for the replace_tasks service*/
+    void init(ServiceClientPool& pool, ros::NodeHandle& n, bool batch, ros::Duration const& timeout);
+    //**Whether transactions are sent in one request*/
+    bool batched() const { return batched_; }
+    //**Runs the transaction, returns false if a step failed (tx.response.message tells which)*/
+    bool call(ReplaceTasks& tx);
+
+  private:
+
+    PooledServiceClient replace_tasks_clt_;
+    HQPControlClients single_;
+    bool batched_;
+  };
+
+}//end namespace grasping_experiments
+
+#endif
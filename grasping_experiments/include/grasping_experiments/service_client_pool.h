@@ -0,0 +1,134 @@
+#ifndef SERVICE_CLIENT_POOL_H
+#define SERVICE_CLIENT_POOL_H
+
+#include <ros/ros.h>
+#include <vector>
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+namespace grasping_experiments
+{
+  //-----------------------------------------------------------
+  /**A service client of a ServiceClientPool. It has the calling interface of ros::ServiceClient, so it can replace one.
+   * Copies share the connection and the latency statistics. Calls of the same client are serialized, since a persistent
+   * connection handles one call at a time anyway. If a call fails on a broken persistent connection (e.g., the server
+   * was restarted), the client reconnects, so that the next call can succeed. The failed call is only repeated for
+   * idempotent services (see ServiceClientPool::serviceClient), since the server may have handled the request before
+   * the connection broke - a repeated set_tasks would add the tasks twice.*/
+  class PooledServiceClient
+  {
+  public:
+
+    PooledServiceClient() {}
+
+    template<class Service>
+    bool call(Service& srv)
+    {
+      if(!entry_)
+        return false;
+
+      boost::mutex::scoped_lock lock(entry_->call_m_);
+      ros::WallTime start = ros::WallTime::now();
+      bool success = entry_->client_.call(srv);
+      if(!success && !entry_->client_.isValid())
+      {
+        reconnect();
+        if(entry_->idempotent_)
+          success = entry_->client_.call(srv);
+      }
+      record(success, (ros::WallTime::now() - start).toSec());
+
+      return success;
+    }
+
+    bool waitForExistence(ros::Duration timeout = ros::Duration(-1));
+    bool exists();
+    //**The resolved service name*/
+    std::string getService() const;
+
+  private:
+
+    friend class ServiceClientPool;
+
+    struct Entry
+    {
+      Entry() : idempotent_(false), bin_width_(0.0), calls_(0), failures_(0), reconnects_(0), latency_sum_(0.0), latency_max_(0.0), last_failed_(false) {}
+
+      boost::mutex call_m_; ///< serializes the calls, guards client_
+      boost::mutex stats_m_; ///< guards the statistics, only held while updating or reading them, never during a call
+      std::string service_;
+      boost::function<ros::ServiceClient()> connect_;
+      ros::ServiceClient client_;
+      bool idempotent_; ///< failed calls are repeated after reconnecting
+
+      double bin_width_;
+      std::vector<boost::uint64_t> histogram_; ///< call latencies, the last bin also counts all larger values
+      boost::uint64_t calls_;
+      boost::uint64_t failures_;
+      boost::uint64_t reconnects_;
+      double latency_sum_;
+      double latency_max_;
+      bool last_failed_;
+    };
+
+    PooledServiceClient(boost::function<ros::ServiceClient()> const& connect, bool idempotent, double bin_width, unsigned int n_bins);
+
+    //**Called with entry_->call_m_ locked*/
+    void reconnect();
+    void record(bool success, double latency);
+    void getStatus(diagnostic_msgs::DiagnosticStatus& status) const;
+
+    boost::shared_ptr<Entry> entry_;
+  };
+  //-----------------------------------------------------------
+  ///**Creates the service clients of a node, by default with persistent connections, and collects their latency statistics.*/
+  class ServiceClientPool
+  {
+  public:
+
+    ServiceClientPool() : persistent_(true), bin_width_(0.001), n_bins_(2000) {}
+
+    /**Sets up the clients created afterwards. Latencies are counted in histograms of n_bins bins of width bin_width [s].*/
+    void init(bool persistent, double bin_width, unsigned int n_bins);
+
+    /**Same as n.serviceClient<Service>(name), but pooled. Set idempotent only for services whose repeated request has
+     * the same effect as a single one, e.g., activate_hqp_control, visualize_task_geometries or services which set an
+     * absolute value (stiffness, gripper position, physics properties). Calls which failed on a broken connection are
+     * repeated for them, not for services like set_tasks, remove_tasks or switch_controller.*/
+    template<class Service>
+    PooledServiceClient serviceClient(ros::NodeHandle const& n, std::string const& name, bool idempotent = false)
+    {
+      PooledServiceClient client(boost::bind(&ServiceClientPool::connect<Service>, n, name, persistent_), idempotent, bin_width_, n_bins_);
+
+      boost::mutex::scoped_lock lock(m_);
+      clients_.push_back(client);
+      return client;
+    }
+
+    /**One status per service: name, level WARN if the last call failed, and the values calls, failures, reconnects,
+     * latency mean/p50/p99/max [ms] and the latency histogram.*/
+    void getDiagnostics(diagnostic_msgs::DiagnosticArray& diagnostics) const;
+
+  private:
+
+    template<class Service>
+    static ros::ServiceClient connect(ros::NodeHandle n, std::string name, bool persistent)
+    {
+      return n.serviceClient<Service>(name, persistent);
+    }
+
+    mutable boost::mutex m_;
+    bool persistent_;
+    double bin_width_;
+    unsigned int n_bins_;
+    std::vector<PooledServiceClient> clients_;
+  };
+
+}//end namespace grasping_experiments
+
+#endif
@@ -0,0 +1,142 @@
+#include <grasping_experiments/async_service_caller.h>
+#include <exception>
+
+namespace grasping_experiments
+{
+//-----------------------------------------------------------------
+bool ServiceCallFuture::valid() const
+{
+    return state_.get() != 0;
+}
+//-----------------------------------------------------------------
+bool ServiceCallFuture::ready() const
+{
+    if(!state_)
+        return false;
+
+    boost::mutex::scoped_lock lock(state_->m_);
+    return state_->done_;
+}
+//-----------------------------------------------------------------
+bool ServiceCallFuture::wait(double timeout) const
+{
+    if(!state_)
+        return false;
+
+    boost::mutex::scoped_lock lock(state_->m_);
+    if(timeout <= 0.0)
+    {
+        while(!state_->done_)
+            state_->cond_.wait(lock);
+    }
+    else
+    {
+        boost::system_time deadline = boost::get_system_time() + boost::posix_time::microseconds((long)(timeout * 1e6));
+        while(!state_->done_)
+            if(!state_->cond_.timed_wait(lock, deadline))
+                break;
+    }
+
+    return state_->done_ && state_->success_;
+}
+//-----------------------------------------------------------------
+double ServiceCallFuture::duration() const
+{
+    if(!state_)
+        return 0.0;
+
+    boost::mutex::scoped_lock lock(state_->m_);
+    return state_->duration_;
+}
+//-----------------------------------------------------------------
+void ServiceCallFuture::finish(bool success, double duration)
+{
+    boost::mutex::scoped_lock lock(state_->m_);
+    state_->done_ = true;
+    state_->success_ = success;
+    state_->duration_ = duration;
+    state_->cond_.notify_all();
+}
+//-----------------------------------------------------------------
+AsyncServiceCaller::AsyncServiceCaller() : stop_(false) {}
+//-----------------------------------------------------------------
+AsyncServiceCaller::~AsyncServiceCaller()
+{
+    {
+        boost::mutex::scoped_lock lock(m_);
+        stop_ = true;
+        cond_.notify_all();
+    }
+    workers_.join_all();
+
+    //fail whatever was not picked up, so nobody waits forever
+    while(!jobs_.empty())
+    {
+        jobs_.front().second.finish(false, 0.0);
+        jobs_.pop_front();
+    }
+}
+//-----------------------------------------------------------------
+void AsyncServiceCaller::start(unsigned int n_workers)
+{
+    for(unsigned int i=0; i<n_workers; i++)
+        workers_.create_thread(boost::bind(&AsyncServiceCaller::work, this));
+}
+//-----------------------------------------------------------------
+ServiceCallFuture AsyncServiceCaller::completed(bool success)
+{
+    ServiceCallFuture future;
+    future.state_.reset(new ServiceCallFuture::State);
+    future.finish(success, 0.0);
+    return future;
+}
+//-----------------------------------------------------------------
+ServiceCallFuture AsyncServiceCaller::run(boost::function<bool()> const& job)
+{
+    ServiceCallFuture future;
+    future.state_.reset(new ServiceCallFuture::State);
+
+    boost::mutex::scoped_lock lock(m_);
+    jobs_.push_back(std::make_pair(job, future));
+    cond_.notify_one();
+
+    return future;
+}
+//-----------------------------------------------------------------
+void AsyncServiceCaller::work()
+{
+    while(true)
+    {
+        std::pair<boost::function<bool()>, ServiceCallFuture> job;
+        {
+            boost::mutex::scoped_lock lock(m_);
+            while(!stop_ && jobs_.empty())
+                cond_.wait(lock);
+
+            if(stop_)
+                return;
+
+            job = jobs_.front();
+            jobs_.pop_front();
+        }
+
+        //an exception must neither end the worker (std::terminate) nor leave the future waiting forever
+        ros::WallTime start = ros::WallTime::now();
+        bool success = false;
+        try
+        {
+            success = job.first();
+        }
+        catch(std::exception const& e)
+        {
+            ROS_ERROR("Asynchronous service call failed with an exception: %s", e.what());
+        }
+        catch(...)
+        {
+            ROS_ERROR("Asynchronous service call failed with an unknown exception.");
+        }
+        job.second.finish(success, (ros::WallTime::now() - start).toSec());
+    }
+}
+//-----------------------------------------------------------------
+}//end namespace grasping_experiments
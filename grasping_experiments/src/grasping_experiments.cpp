@@ -25,6 +25,19 @@ GraspingExperiments::GraspingExperiments() : task_error_tol_(0.0), task_diff_tol
 
     //get params
     nh_.param<bool>("with_gazebo", with_gazebo_,false);
+    nh_.param<bool>("pipeline_transitions", pipeline_transitions_, true);
+    nh_.param<double>("service_timeout", service_timeout_, 10.0);
+    int n_workers;
+    nh_.param<int>("service_workers", n_workers, 3);
+    async_.start(std::max(n_workers, 1));
+    bool persistent_services;
+    double latency_bin_width, diagnostics_period;
+    int latency_bins;
+    nh_.param<bool>("persistent_services", persistent_services, true);
+    nh_.param<double>("latency_bin_width", latency_bin_width, 0.001);
+    nh_.param<int>("latency_bins", latency_bins, 2000);
+    nh_.param<double>("diagnostics_period", diagnostics_period, 1.0);
+    service_pool_.init(persistent_services, latency_bin_width, std::max(latency_bins, 1));
     if(with_gazebo_)
         ROS_INFO("Grasping experiments running in Gazebo.");
 
@@ -33,28 +46,26 @@ GraspingExperiments::GraspingExperiments() : task_error_tol_(0.0), task_diff_tol
     task_success_ = false;
 
     //register general callbacks
-    start_demo_srv_ = nh_.advertiseService("start_demo", &GraspingExperiments::startDemo, this);
-    gimme_beer_srv_ = nh_.advertiseService("gimme_beer", &GraspingExperiments::gimmeBeer, this);
-    lets_dance_srv_ = nh_.advertiseService("lets_dance", &GraspingExperiments::letsDance, this);
-    look_what_i_found_srv_ = nh_.advertiseService("look_what_i_found", &GraspingExperiments::lookWhatIFound, this);
     task_status_sub_ = n_.subscribe("task_status_array", 1, &GraspingExperiments::taskStatusCallback, this);
     joint_state_sub_ = n_.subscribe("joint_states", 1, &GraspingExperiments::jointStateCallback, this);
-    set_tasks_clt_ = n_.serviceClient<hqp_controllers_msgs::SetTasks>("set_tasks");
-    remove_tasks_clt_ = n_.serviceClient<hqp_controllers_msgs::RemoveTasks>("remove_tasks");
-    activate_hqp_control_clt_ = n_.serviceClient<hqp_controllers_msgs::ActivateHQPControl>("activate_hqp_control");
-    visualize_task_geometries_clt_ = n_.serviceClient<hqp_controllers_msgs::VisualizeTaskGeometries>("visualize_task_geometries");
-    set_gazebo_physics_clt_ = n_.serviceClient<gazebo_msgs::SetPhysicsProperties>("set_physics_properties");
-    load_tasks_clt_ = n_.serviceClient<hqp_controllers_msgs::LoadTasks>("load_tasks");
-    reset_hqp_control_clt_ = n_.serviceClient<std_srvs::Empty>("reset_hqp_control");
-
-    switch_controller_clt_ = n_.serviceClient<controller_manager_msgs::SwitchController>("switch_controller");
+    diagnostics_pub_ = n_.advertise<diagnostic_msgs::DiagnosticArray>("diagnostics", 1);
+    diagnostics_timer_ = nh_.createWallTimer(ros::WallDuration(diagnostics_period), &GraspingExperiments::publishDiagnostics, this);
+    set_tasks_clt_ = service_pool_.serviceClient<hqp_controllers_msgs::SetTasks>(n_, "set_tasks");
+    remove_tasks_clt_ = service_pool_.serviceClient<hqp_controllers_msgs::RemoveTasks>(n_, "remove_tasks");
+    activate_hqp_control_clt_ = service_pool_.serviceClient<hqp_controllers_msgs::ActivateHQPControl>(n_, "activate_hqp_control", true);
+    visualize_task_geometries_clt_ = service_pool_.serviceClient<hqp_controllers_msgs::VisualizeTaskGeometries>(n_, "visualize_task_geometries", true);
+    set_gazebo_physics_clt_ = service_pool_.serviceClient<gazebo_msgs::SetPhysicsProperties>(n_, "set_physics_properties", true);
+    load_tasks_clt_ = service_pool_.serviceClient<hqp_controllers_msgs::LoadTasks>(n_, "load_tasks");
+    reset_hqp_control_clt_ = service_pool_.serviceClient<std_srvs::Empty>(n_, "reset_hqp_control");
+
+    switch_controller_clt_ = service_pool_.serviceClient<controller_manager_msgs::SwitchController>(n_, "switch_controller");
     if(!with_gazebo_)
     {
-        get_grasp_interval_clt_ = n_.serviceClient<hqp_controllers_msgs::FindCanTask>("get_grasp_interval");
-        velvet_pos_clt_ = n_.serviceClient<velvet_interface_node::VelvetToPos>("velvet_pos");
-        velvet_grasp_clt_ = n_.serviceClient<velvet_interface_node::SmartGrasp>("velvet_grasp");
-        set_stiffness_clt_ = n_.serviceClient<lbr_fri::SetStiffness>("set_stiffness");
-        next_truck_task_clt_ = n_.serviceClient<std_srvs::Empty>("execute_truck_task");
+        get_grasp_interval_clt_ = service_pool_.serviceClient<hqp_controllers_msgs::FindCanTask>(n_, "get_grasp_interval");
+        velvet_pos_clt_ = service_pool_.serviceClient<velvet_interface_node::VelvetToPos>(n_, "velvet_pos", true);
+        velvet_grasp_clt_ = service_pool_.serviceClient<velvet_interface_node::SmartGrasp>(n_, "velvet_grasp");
+        set_stiffness_clt_ = service_pool_.serviceClient<lbr_fri::SetStiffness>(n_, "set_stiffness", true);
+        next_truck_task_clt_ = service_pool_.serviceClient<std_srvs::Empty>(n_, "execute_truck_task");
 	
 	get_grasp_interval_clt_.waitForExistence();
         velvet_pos_clt_.waitForExistence();
@@ -101,6 +112,12 @@ GraspingExperiments::GraspingExperiments() : task_error_tol_(0.0), task_diff_tol
     load_tasks_clt_.waitForExistence();
     reset_hqp_control_clt_.waitForExistence();
 
+    bool batch_transitions;
+    nh_.param<bool>("batch_transitions", batch_transitions, true);
+    replace_tasks_.init(service_pool_, n_, batch_transitions, ros::Duration(2.0));
+    if(replace_tasks_.batched())
+        ROS_INFO("Phase transitions are sent as replace_tasks transactions.");
+
     //PRE-DEFINED JOINT CONFIGURATIONS
     //configs have to be within the safety margins of the joint limits
 #ifdef HQP_GRIPPER_JOINT
@@ -183,6 +200,32 @@ GraspingExperiments::GraspingExperiments() : task_error_tol_(0.0), task_diff_tol
     place.p_(1) = -0.2;
     place.joints_ += 0.038, -0.26, 0.94, -1.88, 0.51, 1.01, -2.29;
     //place_zones_.push_back(place);
+
+    //PHASE GRAPHS
+    std::map<std::string, std::vector<double> > joint_configurations;
+    joint_configurations["transfer"] = transfer_config_;
+    joint_configurations["sensing"] = sensing_config_;
+    joint_configurations["gimme_beer"] = gimme_beer_config_;
+    std::vector<std::vector<double> > place_zone_joints;
+    for(unsigned int i=0; i<place_zones_.size(); i++)
+        place_zone_joints.push_back(place_zones_[i].joints_);
+
+    std::vector<std::string> invalid_graphs;
+    if(!loadPhaseGraphs(nh_, joint_configurations, place_zone_joints, n_jnts, phase_graphs_, invalid_graphs))
+        ROS_ERROR("No phase graphs loaded from %s - no demos available.", nh_.getNamespace().c_str());
+
+    //each graph is run by the service of the same name
+    for(unsigned int i=0; i<phase_graphs_.size(); i++)
+    {
+        phase_graph_srvs_.push_back(nh_.advertiseService<std_srvs::Empty::Request, std_srvs::Empty::Response>(phase_graphs_[i].name_, boost::bind(&GraspingExperiments::runPhaseGraph, this, _1, _2, i)));
+        ROS_INFO("Phase graph %s with %d phases loaded.", phase_graphs_[i].name_.c_str(), (int)phase_graphs_[i].phases_.size());
+    }
+    //the services of invalid graphs are advertised as well, so that calling them fails instead of the demo silently missing
+    for(unsigned int i=0; i<invalid_graphs.size(); i++)
+    {
+        phase_graph_srvs_.push_back(nh_.advertiseService<std_srvs::Empty::Request, std_srvs::Empty::Response>(invalid_graphs[i], boost::bind(&GraspingExperiments::rejectPhaseGraph, this, _1, _2, invalid_graphs[i])));
+        ROS_ERROR("Phase graph %s is invalid - calling it will fail until its description is fixed.", invalid_graphs[i].c_str());
+    }
 }
 //-----------------------------------------------------------------
 bool GraspingExperiments::setCartesianStiffness(double sx, double sy, double sz, double sa, double sb, double sc)
@@ -207,6 +250,25 @@ bool GraspingExperiments::setCartesianStiffness(double sx, double sy, double sz,
     return true;
 }
 //-----------------------------------------------------------------
+ServiceCallFuture GraspingExperiments::setCartesianStiffnessAsync(std::vector<double> const& stiffness)
+{
+    if(with_gazebo_ || stiffness.empty())
+        return AsyncServiceCaller::completed(true);
+
+    ROS_ASSERT(stiffness.size() == 6);
+    return async_.run(boost::bind(&GraspingExperiments::setCartesianStiffness, this, stiffness[0], stiffness[1], stiffness[2], stiffness[3], stiffness[4], stiffness[5]));
+}
+//-----------------------------------------------------------------
+ServiceCallFuture GraspingExperiments::moveGripperAsync(double angle)
+{
+    if(with_gazebo_)
+        return AsyncServiceCaller::completed(true);
+
+    boost::shared_ptr<velvet_interface_node::VelvetToPos> poscall(new velvet_interface_node::VelvetToPos);
+    poscall->request.angle = angle;
+    return async_.call(velvet_pos_clt_, poscall);
+}
+//-----------------------------------------------------------------
 void GraspingExperiments::activateHQPControl()
 {
     hqp_controllers_msgs::ActivateHQPControl controller_status;
@@ -347,7 +409,7 @@ bool GraspingExperiments::sendStateTasks()
     return true;
 }
 //-----------------------------------------------------------------
-bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joints)
+bool GraspingExperiments::buildJointConfiguration(std::vector<double> const& joints, PhaseTaskSet& set)
 {
 #ifdef HQP_GRIPPER_JOINT
     ROS_ASSERT(joints.size() == 8);//7 joints for the lbr iiwa + 1 velvet fingers joint
@@ -392,7 +454,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //LINK 5 ABOVE HORIZONTAL PLANE
     task.t_links.clear();
@@ -426,7 +488,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //LINK 6 ABOVE HORIZONTAL PLANE
     task.t_links.clear();
@@ -460,7 +522,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //PALM ABOVE HORIZONTAL PLANE
     task.t_links.clear();
@@ -494,7 +556,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
   //POINT BEHIND VERTICAL PLANE
     task.t_links.clear();
@@ -527,7 +589,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
       //PALM ABOVE HORIZONTAL PLANE
     task.t_links.clear();
@@ -561,7 +623,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
       //RIGHT FINGER ABOVE HORIZONTAL PLANE
     task.t_links.clear();
@@ -595,7 +657,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
      //LEFT FINGER ABOVE HORIZONTAL PLANE
     task.t_links.clear();
@@ -629,7 +691,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
    //RIGHT FINGER BEER AVOIDANCE
     task.t_links.clear();
@@ -663,7 +725,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
    //LEFT FINGER BEER AVOIDANCE
     task.t_links.clear();
@@ -697,7 +759,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
    //LINK 4 BEER AVOIDANCE
     task.t_links.clear();
@@ -731,7 +793,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //LINK 5 BEER AVOIDANCE
     task.t_links.clear();
@@ -765,7 +827,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //LINK 6 BEER AVOIDANCE
     task.t_links.clear();
@@ -799,7 +861,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //PALM BEER AVOIDANCE
     task.t_links.clear();
@@ -833,7 +895,7 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 #endif
 
     //SET JOINT VALUES
@@ -894,27 +956,19 @@ bool GraspingExperiments::setJointConfiguration(std::vector<double> const& joint
     task.t_links.push_back(t_link);
 #endif
 
-    tasks_.request.tasks.push_back(task);
-
-    //send the filled task message to the controller
-    if(!sendStateTasks())
-        return false;
+    set.tasks_.request.tasks.push_back(task);
 
     //monitor only the last task
-    monitored_tasks_.push_back(tasks_.response.ids.back());
+    set.monitored_.push_back(set.tasks_.request.tasks.size() - 1);
 
     //visualize all tasks except of the last one
-    std::vector<unsigned int> ids = pers_task_vis_ids_;
-    for(unsigned int i=0; i<tasks_.response.ids.size() - 1;i++)
-        ids.push_back(tasks_.response.ids[i]);
-
-    if(!visualizeStateTasks(ids))
-        return false;
+    for(unsigned int i=0; i<set.tasks_.request.tasks.size() - 1;i++)
+        set.visualized_.push_back(i);
 
     return true;
 }
 //-----------------------------------------------------------------
-bool GraspingExperiments::setObjectPlace(PlaceInterval const& place)
+bool GraspingExperiments::buildObjectPlace(PlaceInterval const& place, PhaseTaskSet& set)
 {
     hqp_controllers_msgs::Task task;
     hqp_controllers_msgs::TaskLink t_link;
@@ -951,7 +1005,7 @@ bool GraspingExperiments::setObjectPlace(PlaceInterval const& place)
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //PLACEMENT_CYLINDER
     task.t_links.clear();
@@ -985,7 +1039,7 @@ bool GraspingExperiments::setObjectPlace(PlaceInterval const& place)
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //GRIPPER APPROACH AXIS ALIGNMENT
     task.t_links.clear();
@@ -1020,7 +1074,7 @@ bool GraspingExperiments::setObjectPlace(PlaceInterval const& place)
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //GRIPPER VERTICAL AXIS ALIGNMENT
     task.t_links.clear();
@@ -1054,28 +1108,19 @@ bool GraspingExperiments::setObjectPlace(PlaceInterval const& place)
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
-
-    //send the filled task message to the controller
-    if(!sendStateTasks())
-        return false;
-
-    //monitor all tasks
-    for(unsigned int i=0; i<tasks_.response.ids.size();i++)
-        monitored_tasks_.push_back(tasks_.response.ids[i]);
+    set.tasks_.request.tasks.push_back(task);
 
-    //visualize all tasks
-    std::vector<unsigned int> ids = pers_task_vis_ids_;
-    for(unsigned int i=0; i<tasks_.response.ids.size();i++)
-        ids.push_back(tasks_.response.ids[i]);
-
-    if(!visualizeStateTasks(ids))
-        return false;
+    //monitor and visualize all tasks
+    for(unsigned int i=0; i<set.tasks_.request.tasks.size();i++)
+    {
+        set.monitored_.push_back(i);
+        set.visualized_.push_back(i);
+    }
 
     return true;
 }
 //-----------------------------------------------------------------
-bool GraspingExperiments::setObjectExtract()
+bool GraspingExperiments::buildObjectExtract(PhaseTaskSet& set)
 {
     hqp_controllers_msgs::Task task;
     hqp_controllers_msgs::TaskLink t_link;
@@ -1112,7 +1157,7 @@ bool GraspingExperiments::setObjectExtract()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //GRIPPER APPROACH AXIS ALIGNMENT
     task.t_links.clear();
@@ -1152,7 +1197,7 @@ bool GraspingExperiments::setObjectExtract()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //GRIPPER VERTICAL AXIS ALIGNMENT
     task.t_links.clear();
@@ -1186,28 +1231,19 @@ bool GraspingExperiments::setObjectExtract()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
-    //send the filled task message to the controller
-    if(!sendStateTasks())
-        return false;
-
-    //monitor all tasks
-    for(unsigned int i=0; i<tasks_.response.ids.size();i++)
-        monitored_tasks_.push_back(tasks_.response.ids[i]);
-
-    //visualize all tasks
-    std::vector<unsigned int> ids = pers_task_vis_ids_;
-    for(unsigned int i=0; i<tasks_.response.ids.size();i++)
-        ids.push_back(tasks_.response.ids[i]);
-
-    if(!visualizeStateTasks(ids))
-        return false;
+    //monitor and visualize all tasks
+    for(unsigned int i=0; i<set.tasks_.request.tasks.size();i++)
+    {
+        set.monitored_.push_back(i);
+        set.visualized_.push_back(i);
+    }
 
     return true;
 }
 //-----------------------------------------------------------------
-bool GraspingExperiments::setGripperExtract(PlaceInterval const& place)
+bool GraspingExperiments::buildGripperExtract(PlaceInterval const& place, PhaseTaskSet& set)
 {
     hqp_controllers_msgs::Task task;
     hqp_controllers_msgs::TaskLink t_link;
@@ -1244,7 +1280,7 @@ bool GraspingExperiments::setGripperExtract(PlaceInterval const& place)
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //GRIPPER APPROACH AXIS ALIGNMENT
     task.t_links.clear();
@@ -1279,7 +1315,7 @@ bool GraspingExperiments::setGripperExtract(PlaceInterval const& place)
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 #if 0
     //GRIPPER VERTICAL AXIS ALIGNMENT
     task.t_links.clear();
@@ -1313,29 +1349,20 @@ bool GraspingExperiments::setGripperExtract(PlaceInterval const& place)
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 #endif
 
-    //send the filled task message to the controller
-    if(!sendStateTasks())
-        return false;
-
-    //monitor all tasks
-    for(unsigned int i=0; i<tasks_.response.ids.size();i++)
-        monitored_tasks_.push_back(tasks_.response.ids[i]);
-
-    //visualize all tasks
-    std::vector<unsigned int> ids = pers_task_vis_ids_;
-    for(unsigned int i=0; i<tasks_.response.ids.size();i++)
-        ids.push_back(tasks_.response.ids[i]);
-
-    if(!visualizeStateTasks(ids))
-        return false;
+    //monitor and visualize all tasks
+    for(unsigned int i=0; i<set.tasks_.request.tasks.size();i++)
+    {
+        set.monitored_.push_back(i);
+        set.visualized_.push_back(i);
+    }
 
     return true;
 }
 //-----------------------------------------------------------------
-bool GraspingExperiments::setGraspApproach()
+bool GraspingExperiments::buildGraspApproach(PhaseTaskSet& set)
 {
     hqp_controllers_msgs::Task task;
     hqp_controllers_msgs::TaskLink t_link;
@@ -1377,7 +1404,7 @@ bool GraspingExperiments::setGraspApproach()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //CONSTRAINT CYLINDER
     task.t_links.clear();
@@ -1411,7 +1438,7 @@ bool GraspingExperiments::setGraspApproach()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //GRIPPER APPROACH AXIS ALIGNMENT
     task.t_links.clear();
@@ -1451,7 +1478,7 @@ bool GraspingExperiments::setGraspApproach()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //GRIPPER VERTICAL AXIS ALIGNMENT
     task.t_links.clear();
@@ -1485,7 +1512,7 @@ bool GraspingExperiments::setGraspApproach()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
 #else
     ROS_ASSERT(grasp_.r1_ <= grasp_.r2_);
@@ -1521,7 +1548,7 @@ bool GraspingExperiments::setGraspApproach()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //UPPER GRASP INTERVAL PLANE
     task.t_links.clear();
@@ -1553,7 +1580,7 @@ bool GraspingExperiments::setGraspApproach()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //INNER CONSTRAINT CYLINDER
     task.t_links.clear();
@@ -1586,7 +1613,7 @@ bool GraspingExperiments::setGraspApproach()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //OUTER CONSTRAINT CYLINDER
     task.t_links.clear();
@@ -1619,7 +1646,7 @@ bool GraspingExperiments::setGraspApproach()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //COPLANAR LINES CONSTRAINT
     task.t_links.clear();
@@ -1653,7 +1680,7 @@ bool GraspingExperiments::setGraspApproach()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 
     //CONE CONSTRAINT
     task.t_links.clear();
@@ -1687,28 +1714,108 @@ bool GraspingExperiments::setGraspApproach()
     t_link.geometries.push_back(t_geom);
     task.t_links.push_back(t_link);
 
-    tasks_.request.tasks.push_back(task);
+    set.tasks_.request.tasks.push_back(task);
 #endif
 
+    //monitor and visualize all tasks
+    for(unsigned int i=0; i<set.tasks_.request.tasks.size();i++)
+    {
+        set.monitored_.push_back(i);
+        set.visualized_.push_back(i);
+    }
+
+    return true;
+}
+//-----------------------------------------------------------------
+bool GraspingExperiments::buildCustomTasks(TaskTemplate const& task_template, PhaseTaskSet& set)
+{
+    set.tasks_.request.tasks = task_template.tasks_;
+
+    //monitor the given tasks
+    set.monitored_ = task_template.monitored_;
+
+    //visualize all tasks
+    for(unsigned int i=0; i<set.tasks_.request.tasks.size();i++)
+        set.visualized_.push_back(i);
+
+    return true;
+}
+//-----------------------------------------------------------------
+bool GraspingExperiments::applyPhaseTasks(PhaseTaskSet const& set)
+{
+    tasks_.request = set.tasks_.request;
+
     //send the filled task message to the controller
     if(!sendStateTasks())
         return false;
 
-    //monitor all tasks
-    for(unsigned int i=0; i<tasks_.response.ids.size();i++)
-        monitored_tasks_.push_back(tasks_.response.ids[i]);
+    if(tasks_.response.ids.size() != tasks_.request.tasks.size())
+    {
+        ROS_ERROR("GraspingExperiments::applyPhaseTasks(): got %d ids for %d tasks!", (int)tasks_.response.ids.size(), (int)tasks_.request.tasks.size());
+        return false;
+    }
+
+    for(unsigned int i=0; i<set.monitored_.size();i++)
+        monitored_tasks_.push_back(tasks_.response.ids[set.monitored_[i]]);
 
-    //visualize all tasks
-    std::vector<unsigned int> ids = pers_task_vis_ids_;
-    for(unsigned int i=0; i<tasks_.response.ids.size();i++)
-        ids.push_back(tasks_.response.ids[i]);
+    return true;
+}
+//-----------------------------------------------------------------
+bool GraspingExperiments::replaceStateTasks(PhaseTaskSet const& set, ServiceCallFuture const& stiffness)
+{
+    ReplaceTasks tx;
+    tx.request.deactivate = true;
+    tx.request.remove_ids = tasks_.response.ids;
+    tx.request.tasks = set.tasks_.request.tasks;
+    //activate within the transaction, unless the stiffness is still being changed
+    tx.request.activate = stiffness.ready() && stiffness.wait(service_timeout_);
+    tx.request.visualize_ids = pers_task_vis_ids_;
+    tx.request.visualize_indices = set.visualized_;
+
+    if(!replace_tasks_.call(tx))
+    {
+        ROS_ERROR("GraspingExperiments::replaceStateTasks(): %s!", tx.response.message.c_str());
+        return false;
+    }
+
+    //same bookkeeping as resetState() and applyPhaseTasks()
+    monitored_tasks_.clear();
+    t_prog_prev_.resize(0);
+    tasks_.request = set.tasks_.request;
+    tasks_.response.ids = tx.response.ids;
+    tasks_.response.success = true;
 
-    if(!visualizeStateTasks(ids))
+    if(tasks_.response.ids.size() != tasks_.request.tasks.size())
+    {
+        ROS_ERROR("GraspingExperiments::replaceStateTasks(): got %d ids for %d tasks!", (int)tasks_.response.ids.size(), (int)tasks_.request.tasks.size());
         return false;
+    }
+
+    for(unsigned int i=0; i<set.monitored_.size();i++)
+        monitored_tasks_.push_back(tasks_.response.ids[set.monitored_[i]]);
+
+    if(!tx.request.activate)
+    {
+        if(!stiffness.wait(service_timeout_))
+        {
+            ROS_ERROR("GraspingExperiments::replaceStateTasks(): could not set the stiffness!");
+            return false;
+        }
+        activateHQPControl();
+    }
 
     return true;
 }
 //-----------------------------------------------------------------
+std::vector<unsigned int> GraspingExperiments::phaseVisualizationIds(PhaseTaskSet const& set) const
+{
+    std::vector<unsigned int> ids = pers_task_vis_ids_;
+    for(unsigned int i=0; i<set.visualized_.size();i++)
+        ids.push_back(tasks_.response.ids[set.visualized_[i]]);
+
+    return ids;
+}
+//-----------------------------------------------------------------
 void GraspingExperiments::taskStatusCallback( const hqp_controllers_msgs::TaskStatusArrayPtr& msg)
 {
     boost::mutex::scoped_lock lock(manipulator_tasks_m_, boost::try_to_lock);
@@ -1955,6 +2062,13 @@ void GraspingExperiments::jointStateCallback( const sensor_msgs::JointStatePtr&
 
 }
 //-----------------------------------------------------------------
+void GraspingExperiments::publishDiagnostics(const ros::WallTimerEvent& event)
+{
+    diagnostic_msgs::DiagnosticArray diagnostics;
+    service_pool_.getDiagnostics(diagnostics);
+    diagnostics_pub_.publish(diagnostics);
+}
+//-----------------------------------------------------------------
 bool GraspingExperiments::loadPersistentTasks()
 {
     hqp_controllers_msgs::LoadTasks persistent_tasks;
@@ -1972,405 +2086,6 @@ bool GraspingExperiments::loadPersistentTasks()
     return true;
 }
 //-----------------------------------------------------------------
-bool GraspingExperiments::startDemo(std_srvs::Empty::Request  &req, std_srvs::Empty::Response &res )
-{
-    std_srvs::Empty srv;
-    //PICK EMPTY PALLET
-    ROS_INFO("Picking up empty pallet");
-    next_truck_task_clt_.call(srv);
-    //MOVE TO UNLOADING POSE
-    ROS_INFO("Moving to unloading pose");
-    next_truck_task_clt_.call(srv);
-
-
-#if 0
-#endif
-    deactivateHQPControl();
-    resetState();
-    reset_hqp_control_clt_.call(srv);
-    pers_task_vis_ids_.clear();
-
-    if(!loadPersistentTasks())
-    {
-        ROS_ERROR("Could not load persistent tasks!");
-        safeShutdown();
-        return false;
-    }
-
-    if(!with_gazebo_)
-    {
-        //VELVET INITIAL POSE
-        velvet_interface_node::VelvetToPos poscall;
-        poscall.request.angle = 0.3;
-
-        if(!velvet_pos_clt_.call(poscall))
-        {
-            ROS_ERROR("could not call velvet to pos");
-            ROS_BREAK();
-        }
-    }
-
-    for(unsigned int i=0; i<place_zones_.size(); i++)
-    {
-        bool grasp_success = false;
-        while(!grasp_success)
-        {
-            {//MANIPULATOR SENSING CONFIGURATION
-                ROS_INFO("Trying to put the manipulator in sensing configuration.");
-                boost::mutex::scoped_lock lock(manipulator_tasks_m_);
-                task_status_changed_ = false;
-                task_success_ = false;
-                deactivateHQPControl();
-                if(!resetState())
-                {
-                    ROS_ERROR("Could not reset the state!");
-                    safeShutdown();
-                    return false;
-                }
-                if(!setCartesianStiffness(1000, 1000, 1000, 100, 100, 100))
-                {
-                    safeShutdown();
-                    return false;
-                }
-
-                if(!setJointConfiguration(sensing_config_))
-                {
-                    ROS_ERROR("Could not set manipulator sensing state!");
-                    safeShutdown();
-                    return false;
-                }
-                task_error_tol_ = 1e-2;
-                activateHQPControl();
-
-                while(!task_status_changed_)
-                    cond_.wait(lock);
-
-                if(!task_success_)
-                {
-                    ROS_ERROR("Could not complete the manipulator sensing state tasks!");
-                    safeShutdown();
-                    return false;
-                }
-                ROS_INFO("Manipulator sensing state tasks executed successfully.");
-            }
-
-            {//GRASP APPROACH
-                ROS_INFO("Trying grasp approach.");
-                boost::mutex::scoped_lock lock(manipulator_tasks_m_);
-                task_status_changed_ = false;
-                task_success_ = false;
-                deactivateHQPControl();
-                if(!resetState())
-                {
-                    ROS_ERROR("Could not reset the state!");
-                    safeShutdown();
-                    return false;
-                }
-		 if(!with_gazebo_)
-                    if(!getGraspInterval())
-                        ROS_WARN("Could not obtain the grasp intervall - using default interval!");
-
-#if 0
-#endif
-
-                if(!setCartesianStiffness(1000, 1000, 100, 100, 100, 100))
-                {
-                    safeShutdown();
-                    return false;
-                }
-
-                if(!setGraspApproach())
-                {
-                    ROS_ERROR("Could not set the grasp approach!");
-                    safeShutdown();
-                    return false;
-                }
-                task_error_tol_ =  1e-3;
-                activateHQPControl();
-
-                while(!task_status_changed_)
-                    cond_.wait(lock);
-
-                if(!task_success_)
-                {
-                    ROS_ERROR("Could not complete the grasp approach tasks!");
-                    safeShutdown();
-                    return false;
-                }
-
-                ROS_INFO("Grasp approach tasks executed successfully.");
-            }
-
-
-            if(!with_gazebo_)
-            {
-                //SET GRASP STIFFNESS
-                if(!setCartesianStiffness(1000, 50, 30, 100, 100, 10))
-                {
-                    safeShutdown();
-                    return false;
-                }
-
-                deactivateHQPControl();
-                //VELVET GRASP_
-                velvet_interface_node::SmartGrasp graspcall;
-                graspcall.request.current_threshold_contact = 20;
-                graspcall.request.current_threshold_final = 35;
-                graspcall.request.max_belt_travel_mm = 90;
-                graspcall.request.phalange_delta_rad = 0.02;
-                graspcall.request.gripper_closed_thresh = 1.5;
-                graspcall.request.check_phalanges = true;
-
-                if(!velvet_grasp_clt_.call(graspcall)) {
-                    ROS_ERROR("could not call grasping");
-                    ROS_BREAK();
-                }
-                if(!graspcall.response.success)
-                    ROS_ERROR("Grasp failed!");
-                else
-                {
-                    grasp_success = true;
-                    ROS_INFO("Grasp aquired.");
-                }
-#if 0
-		grasp_success = true; //RRRRRRRRREEEEEEEEEEEMMMMMMMMMOOOOOOVVVVVVEEEEEEEE!!!!!!!!!!
-#endif
-            }
-            else
-                grasp_success = true;
-
-        }
-        {//OBJECT EXTRACT
-            ROS_INFO("Trying object extract.");
-            boost::mutex::scoped_lock lock(manipulator_tasks_m_);
-            task_status_changed_ = false;
-            task_success_ = false;
-            deactivateHQPControl();
-            if(!resetState())
-            {
-                ROS_ERROR("Could not reset the state!");
-                safeShutdown();
-                return false;
-            }
-            if(!setCartesianStiffness(1000, 1000, 1000, 100, 100, 100))
-            {
-                safeShutdown();
-                return false;
-            }
-            if(!setObjectExtract())
-            {
-                ROS_ERROR("Could not set the object extract!");
-                safeShutdown();
-                return false;
-            }
-
-            task_error_tol_ = 1e-2;
-            activateHQPControl();
-
-            while(!task_status_changed_)
-                cond_.wait(lock);
-
-            if(!task_success_)
-            {
-                ROS_ERROR("Could not complete the object extract tasks!");
-                safeShutdown();
-                return false;
-            }
-            ROS_INFO("Object extract tasks executed successfully.");
-        }
-
-        {//OBJECT TRANSFER
-            ROS_INFO("Trying object transfer configuration.");
-
-            boost::mutex::scoped_lock lock(manipulator_tasks_m_);
-            task_status_changed_ = false;
-            task_success_ = false;
-            deactivateHQPControl();
-            if(!resetState())
-            {
-                ROS_ERROR("Could not reset the state!");
-                safeShutdown();
-                return false;
-            }
-            if(!setCartesianStiffness(1000, 1000, 1000, 100, 100, 100))
-            {
-                safeShutdown();
-                return false;
-            }
-
-            if(!setJointConfiguration(place_zones_[i].joints_))
-            {
-                ROS_ERROR("Could not set the object transfer configuration!");
-                safeShutdown();
-                return false;
-            }
-            task_error_tol_ = 1e-3;
-            activateHQPControl();
-
-            while(!task_status_changed_)
-                cond_.wait(lock);
-
-            if(!task_success_)
-            {
-                ROS_ERROR("Could not complete the object transfer configuration!");
-                safeShutdown();
-                return false;
-            }
-            ROS_INFO("Object transfer tasks executed successfully.");
-        }
-
-        {//OBJECT PLACE
-            ROS_INFO("Trying object place.");
-            boost::mutex::scoped_lock lock(manipulator_tasks_m_);
-            task_status_changed_ = false;
-            task_success_ = false;
-            deactivateHQPControl();
-            if(!resetState())
-            {
-                ROS_ERROR("Could not reset the state!");
-                safeShutdown();
-                return false;
-            }
-            if(!setCartesianStiffness(100, 1000, 1000, 100, 100, 100))
-            {
-                safeShutdown();
-                return false;
-            }
-
-            if(!setObjectPlace(place_zones_[i]))
-            {
-                ROS_ERROR("Could not set the object place!");
-                safeShutdown();
-                return false;
-            }
-            task_error_tol_ = 1e-4;
-            task_diff_tol_ = 1e-5;
-            activateHQPControl();
-
-            while(!task_status_changed_)
-                cond_.wait(lock);
-
-            if(!task_success_)
-            {
-                ROS_ERROR("Could not complete the object place tasks!");
-                safeShutdown();
-                return false;
-            }
-            ROS_INFO("Object place tasks executed successfully.");
-        }
-
-        if(!with_gazebo_)
-        {
-            velvet_interface_node::VelvetToPos poscall2;
-            poscall2.request.angle = 0.2;
-
-            if(!velvet_pos_clt_.call(poscall2))
-            {
-                ROS_ERROR("could not call velvet to pos");
-                ROS_BREAK();
-            }
-        }
-
-        {//GRIPPER EXTRACT
-            ROS_INFO("Trying gripper extract.");
-            boost::mutex::scoped_lock lock(manipulator_tasks_m_);
-            task_status_changed_ = false;
-            task_success_ = false;
-            deactivateHQPControl();
-            if(!resetState())
-            {
-                ROS_ERROR("Could not reset the state!");
-                safeShutdown();
-                return false;
-            }
-            if(!setCartesianStiffness(1000, 1000, 1000, 100, 100, 100))
-            {
-                safeShutdown();
-                return false;
-            }
-
-            if(!setGripperExtract(place_zones_[i]))
-            {
-                ROS_ERROR("Could not set the gripper extract!");
-                safeShutdown();
-                return false;
-            }
-
-            task_error_tol_ = 5 * 1e-3;
-            activateHQPControl();
-
-            while(!task_status_changed_)
-                cond_.wait(lock);
-
-            if(!task_success_)
-            {
-                ROS_ERROR("Could not complete the gripper extract tasks!");
-                safeShutdown();
-                return false;
-            }
-            ROS_INFO("Gripper extract tasks executed successfully.");
-        }
-    }
-
-    {//MANIPULATOR TRANSFER CONFIGURATION
-        ROS_INFO("Trying to put the manipulator in transfer configuration.");
-
-        boost::mutex::scoped_lock lock(manipulator_tasks_m_);
-        task_status_changed_ = false;
-        task_success_ = false;
-        deactivateHQPControl();
-        if(!resetState())
-        {
-            ROS_ERROR("Could not reset the state!");
-            safeShutdown();
-            return false;
-        }
-        if(!setCartesianStiffness(1000, 1000, 1000, 100, 100, 100))
-        {
-            safeShutdown();
-            return false;
-        }
-
-        if(!setJointConfiguration(transfer_config_))
-        {
-            ROS_ERROR("Could not set manipulator transfer configuration!");
-            safeShutdown();
-            return false;
-        }
-        task_error_tol_ = 1e-2;
-        activateHQPControl();
-
-        while(!task_status_changed_)
-            cond_.wait(lock);
-
-        if(!task_success_)
-        {
-            ROS_ERROR("Could not complete the manipulator transfer configuration tasks!");
-            safeShutdown();
-            return false;
-        }
-        ROS_INFO("Manipulator transfer configuration tasks executed successfully.");
-    }
-
-    deactivateHQPControl();
-    resetState();
-    reset_hqp_control_clt_.call(srv);
-    pers_task_vis_ids_.clear();
-    //MOVE TO DROP OFF
-    ROS_INFO("Moving to drop-off pose");
-    next_truck_task_clt_.call(srv);
-
-    //MOVE HOME 
-    ROS_INFO("Moving back home");
-    next_truck_task_clt_.call(srv);
-
-#if 0
-#endif
-    ROS_INFO("DEMO FINISHED.");
-
-    return true;
-}
-//--------------------------------------------------------------------------
 }//end namespace grasping_experiments
 
 
@@ -0,0 +1,188 @@
+#include <ros/ros.h>
+#include <set>
+#include <boost/thread/mutex.hpp>
+#include <std_srvs/Empty.h>
+#include <hqp_controllers_msgs/ActivateHQPControl.h>
+#include <hqp_controllers_msgs/RemoveTasks.h>
+#include <hqp_controllers_msgs/SetTasks.h>
+#include <hqp_controllers_msgs/VisualizeTaskGeometries.h>
+#include <grasping_experiments/ReplaceTasks.h>
+
+/////////////////////////////////
+//   HQP CONTROLLER STAND-IN   //
+/////////////////////////////////
+
+// Offers the task services of the HQP controller (in its private namespace) without controlling anything, so phase
+// transitions can be timed without the robot. Each call takes ~processing_time seconds. With ~batch (default), it also
+// offers ~replace_tasks like a controller which supports transactions.
+
+namespace grasping_experiments
+{
+//-----------------------------------------------------------------
+class HQPControllerStandIn
+{
+public:
+
+    HQPControllerStandIn() : nh_("~"), active_(false), next_id_(0)
+    {
+        bool batch;
+        nh_.param<double>("processing_time", processing_time_, 0.001);
+        nh_.param<bool>("batch", batch, true);
+
+        activate_srv_ = nh_.advertiseService("activate_hqp_control", &HQPControllerStandIn::activateHQPControl, this);
+        remove_srv_ = nh_.advertiseService("remove_tasks", &HQPControllerStandIn::removeTasks, this);
+        set_srv_ = nh_.advertiseService("set_tasks", &HQPControllerStandIn::setTasks, this);
+        visualize_srv_ = nh_.advertiseService("visualize_task_geometries", &HQPControllerStandIn::visualizeTaskGeometries, this);
+        reset_srv_ = nh_.advertiseService("reset_hqp_control", &HQPControllerStandIn::resetHQPControl, this);
+        if(batch)
+            replace_srv_ = nh_.advertiseService("replace_tasks", &HQPControllerStandIn::replaceTasks, this);
+    }
+
+private:
+
+    ros::NodeHandle nh_;
+    boost::mutex m_;
+    double processing_time_;
+    bool active_;
+    unsigned int next_id_;
+    std::set<unsigned int> tasks_; ///< ids of the tasks which are set
+
+    ros::ServiceServer activate_srv_;
+    ros::ServiceServer remove_srv_;
+    ros::ServiceServer set_srv_;
+    ros::ServiceServer visualize_srv_;
+    ros::ServiceServer reset_srv_;
+    ros::ServiceServer replace_srv_;
+
+    void process()
+    {
+        if(processing_time_ > 0.0)
+            ros::WallDuration(processing_time_).sleep();
+    }
+
+    bool activateHQPControl(hqp_controllers_msgs::ActivateHQPControl::Request& req, hqp_controllers_msgs::ActivateHQPControl::Response& res)
+    {
+        boost::mutex::scoped_lock lock(m_);
+        process();
+        active_ = req.active;
+        return true;
+    }
+
+    bool removeTasks(hqp_controllers_msgs::RemoveTasks::Request& req, hqp_controllers_msgs::RemoveTasks::Response& res)
+    {
+        boost::mutex::scoped_lock lock(m_);
+        process();
+        res.success = true;
+        for(unsigned int i=0; i<req.ids.size(); i++)
+            if(tasks_.erase(req.ids[i]) == 0)
+                res.success = false;
+
+        return true;
+    }
+
+    bool setTasks(hqp_controllers_msgs::SetTasks::Request& req, hqp_controllers_msgs::SetTasks::Response& res)
+    {
+        boost::mutex::scoped_lock lock(m_);
+        process();
+        res.ids.clear();
+        for(unsigned int i=0; i<req.tasks.size(); i++)
+        {
+            tasks_.insert(next_id_);
+            res.ids.push_back(next_id_++);
+        }
+        res.success = true;
+        return true;
+    }
+
+    bool visualizeTaskGeometries(hqp_controllers_msgs::VisualizeTaskGeometries::Request& req, hqp_controllers_msgs::VisualizeTaskGeometries::Response& res)
+    {
+        boost::mutex::scoped_lock lock(m_);
+        process();
+        res.success = true;
+        for(unsigned int i=0; i<req.ids.size(); i++)
+            if(tasks_.count(req.ids[i]) == 0)
+                res.success = false;
+
+        return true;
+    }
+
+    bool resetHQPControl(std_srvs::Empty::Request& req, std_srvs::Empty::Response& res)
+    {
+        boost::mutex::scoped_lock lock(m_);
+        process();
+        active_ = false;
+        tasks_.clear();
+        return true;
+    }
+
+    //** each step costs the same processing time as the single call, so only the round trips are saved*/
+    bool replaceTasks(ReplaceTasks::Request& req, ReplaceTasks::Response& res)
+    {
+        boost::mutex::scoped_lock lock(m_);
+        res.ids.clear();
+        res.success = false;
+
+        if(req.deactivate)
+        {
+            process();
+            active_ = false;
+        }
+
+        if(!req.remove_ids.empty())
+        {
+            process();
+            for(unsigned int i=0; i<req.remove_ids.size(); i++)
+                if(tasks_.erase(req.remove_ids[i]) == 0)
+                {
+                    res.message = "could not remove tasks";
+                    return true;
+                }
+        }
+
+        if(!req.tasks.empty())
+        {
+            process();
+            for(unsigned int i=0; i<req.tasks.size(); i++)
+            {
+                tasks_.insert(next_id_);
+                res.ids.push_back(next_id_++);
+            }
+        }
+
+        if(req.activate)
+        {
+            process();
+            active_ = true;
+        }
+
+        if(!req.visualize_ids.empty() || !req.visualize_indices.empty())
+        {
+            process();
+            for(unsigned int i=0; i<req.visualize_indices.size(); i++)
+                if(req.visualize_indices[i] >= res.ids.size())
+                {
+                    res.message = "visualize index out of range";
+                    return true;
+                }
+        }
+
+        res.success = true;
+        return true;
+    }
+};
+//-----------------------------------------------------------------
+}//end namespace grasping_experiments
+
+//---------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "hqp_controller_stand_in");
+
+    grasping_experiments::HQPControllerStandIn stand_in;
+
+    ROS_INFO("HQP controller stand-in ready");
+    ros::spin();
+
+    return 0;
+}
+//---------------------------------------------------------------------
@@ -0,0 +1,457 @@
+#include <grasping_experiments/phase_graph.h>
+
+namespace grasping_experiments
+{
+//-----------------------------------------------------------------
+// XmlRpc helpers - rosparam gives integers for numbers written without a decimal point
+//-----------------------------------------------------------------
+static bool toDouble(XmlRpc::XmlRpcValue& value, double& d)
+{
+    if(value.getType() == XmlRpc::XmlRpcValue::TypeDouble)
+        d = static_cast<double>(value);
+    else if(value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+        d = static_cast<int>(value);
+    else
+        return false;
+
+    return true;
+}
+//-----------------------------------------------------------------
+static bool toDoubleArray(XmlRpc::XmlRpcValue& value, std::vector<double>& data)
+{
+    if(value.getType() != XmlRpc::XmlRpcValue::TypeArray)
+        return false;
+
+    data.resize(value.size());
+    for(int i=0; i<value.size(); i++)
+        if(!toDouble(value[i], data[i]))
+            return false;
+
+    return true;
+}
+//-----------------------------------------------------------------
+static bool toStringArray(XmlRpc::XmlRpcValue& value, std::vector<std::string>& data)
+{
+    if(value.getType() != XmlRpc::XmlRpcValue::TypeArray)
+        return false;
+
+    data.clear();
+    for(int i=0; i<value.size(); i++)
+    {
+        if(value[i].getType() != XmlRpc::XmlRpcValue::TypeString)
+            return false;
+        data.push_back(static_cast<std::string>(value[i]));
+    }
+    return true;
+}
+//-----------------------------------------------------------------
+static bool toInt(XmlRpc::XmlRpcValue& value, int& i)
+{
+    if(value.getType() != XmlRpc::XmlRpcValue::TypeInt)
+        return false;
+
+    i = static_cast<int>(value);
+    return true;
+}
+//-----------------------------------------------------------------
+static bool toBool(XmlRpc::XmlRpcValue& value, bool& b)
+{
+    if(value.getType() == XmlRpc::XmlRpcValue::TypeBoolean)
+        b = static_cast<bool>(value);
+    else if(value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+        b = static_cast<int>(value) != 0;
+    else
+        return false;
+
+    return true;
+}
+//-----------------------------------------------------------------
+static bool toString(XmlRpc::XmlRpcValue& value, std::string& s)
+{
+    if(value.getType() != XmlRpc::XmlRpcValue::TypeString)
+        return false;
+
+    s = static_cast<std::string>(value);
+    return true;
+}
+//-----------------------------------------------------------------
+///**Parses a task in the format of the task_definitions.yaml file loaded by the HQP controller.*/
+static bool parseTask(XmlRpc::XmlRpcValue& t, hqp_controllers_msgs::Task& task)
+{
+    int t_type, priority, d_type;
+    if(t.getType() != XmlRpc::XmlRpcValue::TypeStruct || !t.hasMember("t_type") || !t.hasMember("priority") || !t.hasMember("name") ||
+       !t.hasMember("is_equality_task") || !t.hasMember("task_frame") || !t.hasMember("ds") || !t.hasMember("di") ||
+       !t.hasMember("dynamics") || !t.hasMember("t_links"))
+        return false;
+
+    if(!toInt(t["t_type"], t_type) || !toInt(t["priority"], priority) || !toString(t["name"], task.name) ||
+       !toBool(t["is_equality_task"], task.is_equality_task) || !toString(t["task_frame"], task.task_frame) ||
+       !toDouble(t["ds"], task.ds) || !toDouble(t["di"], task.di))
+        return false;
+    task.t_type = t_type;
+    task.priority = priority;
+
+    XmlRpc::XmlRpcValue& dynamics = t["dynamics"];
+    if(dynamics.getType() != XmlRpc::XmlRpcValue::TypeStruct || !dynamics.hasMember("d_type") || !dynamics.hasMember("d_data") ||
+       !toInt(dynamics["d_type"], d_type) || !toDoubleArray(dynamics["d_data"], task.dynamics.d_data))
+        return false;
+    task.dynamics.d_type = d_type;
+
+    XmlRpc::XmlRpcValue& t_links = t["t_links"];
+    if(t_links.getType() != XmlRpc::XmlRpcValue::TypeArray)
+        return false;
+
+    task.t_links.resize(t_links.size());
+    for(int l=0; l<t_links.size(); l++)
+    {
+        XmlRpc::XmlRpcValue& t_link = t_links[l];
+        if(t_link.getType() != XmlRpc::XmlRpcValue::TypeStruct || !t_link.hasMember("link_frame") || !t_link.hasMember("geometries") ||
+           !toString(t_link["link_frame"], task.t_links[l].link_frame) || t_link["geometries"].getType() != XmlRpc::XmlRpcValue::TypeArray)
+            return false;
+
+        XmlRpc::XmlRpcValue& geometries = t_link["geometries"];
+        task.t_links[l].geometries.resize(geometries.size());
+        for(int g=0; g<geometries.size(); g++)
+        {
+            int g_type;
+            if(geometries[g].getType() != XmlRpc::XmlRpcValue::TypeStruct || !geometries[g].hasMember("g_type") || !geometries[g].hasMember("g_data") ||
+               !toInt(geometries[g]["g_type"], g_type) || !toDoubleArray(geometries[g]["g_data"], task.t_links[l].geometries[g].g_data))
+                return false;
+            task.t_links[l].geometries[g].g_type = g_type;
+        }
+    }
+    return true;
+}
+//-----------------------------------------------------------------
+static bool parseTaskTemplate(XmlRpc::XmlRpcValue& t, const std::map<std::string, std::vector<double> >& joint_configurations,
+                              const std::vector<std::vector<double> >& place_zone_joints, unsigned int n_joints, TaskTemplate& task_template)
+{
+    std::string type;
+    if(t.getType() != XmlRpc::XmlRpcValue::TypeStruct || !t.hasMember("type") || !toString(t["type"], type))
+    {
+        ROS_ERROR("The tasks of a phase need a type.");
+        return false;
+    }
+
+    task_template.place_zone_ = 0;
+    task_template.query_grasp_interval_ = false;
+    if(t.hasMember("place_zone"))
+    {
+        int place_zone;
+        if(!toInt(t["place_zone"], place_zone) || place_zone < 0 || place_zone >= (int)place_zone_joints.size())
+        {
+            ROS_ERROR("Invalid place_zone, there are %d place zones.", (int)place_zone_joints.size());
+            return false;
+        }
+        task_template.place_zone_ = place_zone;
+    }
+
+    if(type == "joint_configuration")
+    {
+        task_template.type_ = TaskTemplate::JOINT_CONFIGURATION;
+        std::string configuration;
+        if(t.hasMember("joints"))
+        {
+            if(!toDoubleArray(t["joints"], task_template.joints_))
+            {
+                ROS_ERROR("The joints of a joint_configuration have to be numbers.");
+                return false;
+            }
+        }
+        else if(t.hasMember("configuration") && toString(t["configuration"], configuration))
+        {
+            std::map<std::string, std::vector<double> >::const_iterator it = joint_configurations.find(configuration);
+            if(it == joint_configurations.end())
+            {
+                ROS_ERROR("Unknown joint configuration %s.", configuration.c_str());
+                return false;
+            }
+            task_template.joints_ = it->second;
+        }
+        else if(t.hasMember("place_zone"))
+            task_template.joints_ = place_zone_joints[task_template.place_zone_];
+        else
+        {
+            ROS_ERROR("A joint_configuration needs joints, a configuration name or a place_zone.");
+            return false;
+        }
+
+        if(task_template.joints_.size() != n_joints)
+        {
+            ROS_ERROR("A joint_configuration needs %d joint values, got %d.", n_joints, (int)task_template.joints_.size());
+            return false;
+        }
+    }
+    else if(type == "grasp_approach")
+    {
+        task_template.type_ = TaskTemplate::GRASP_APPROACH;
+        if(t.hasMember("query_grasp_interval") && !toBool(t["query_grasp_interval"], task_template.query_grasp_interval_))
+        {
+            ROS_ERROR("query_grasp_interval has to be a boolean.");
+            return false;
+        }
+    }
+    else if(type == "object_extract")
+        task_template.type_ = TaskTemplate::OBJECT_EXTRACT;
+    else if(type == "object_place")
+        task_template.type_ = TaskTemplate::OBJECT_PLACE;
+    else if(type == "gripper_extract")
+        task_template.type_ = TaskTemplate::GRIPPER_EXTRACT;
+    else if(type == "custom")
+    {
+        task_template.type_ = TaskTemplate::CUSTOM;
+        if(!t.hasMember("tasks") || t["tasks"].getType() != XmlRpc::XmlRpcValue::TypeArray || t["tasks"].size() == 0)
+        {
+            ROS_ERROR("A custom task template needs a non-empty list of tasks.");
+            return false;
+        }
+        XmlRpc::XmlRpcValue& tasks = t["tasks"];
+        task_template.tasks_.resize(tasks.size());
+        for(int i=0; i<tasks.size(); i++)
+            if(!parseTask(tasks[i], task_template.tasks_[i]))
+            {
+                ROS_ERROR("Could not parse custom task %d - the format is the one of the task definitions.", i);
+                return false;
+            }
+
+        //monitor all tasks by default
+        task_template.monitored_.clear();
+        if(t.hasMember("monitored"))
+        {
+            std::vector<double> monitored;
+            if(!toDoubleArray(t["monitored"], monitored))
+            {
+                ROS_ERROR("monitored has to be a list of task indices.");
+                return false;
+            }
+            for(unsigned int i=0; i<monitored.size(); i++)
+            {
+                if(monitored[i] < 0 || monitored[i] >= tasks.size())
+                {
+                    ROS_ERROR("Monitored task index %g is out of range.", monitored[i]);
+                    return false;
+                }
+                task_template.monitored_.push_back((unsigned int)monitored[i]);
+            }
+        }
+        else
+            for(unsigned int i=0; i<task_template.tasks_.size(); i++)
+                task_template.monitored_.push_back(i);
+    }
+    else
+    {
+        ROS_ERROR("Unknown task template type %s.", type.c_str());
+        return false;
+    }
+    return true;
+}
+//-----------------------------------------------------------------
+///**Resolves a transition target given by name, "end" or "abort" to a phase index.*/
+static bool resolveTransition(XmlRpc::XmlRpcValue& value, const std::map<std::string, int>& phase_ids, int& target)
+{
+    std::string name;
+    if(!toString(value, name))
+        return false;
+
+    if(name == "end")
+        target = PHASE_END;
+    else if(name == "abort")
+        target = PHASE_ABORT;
+    else
+    {
+        std::map<std::string, int>::const_iterator it = phase_ids.find(name);
+        if(it == phase_ids.end())
+        {
+            ROS_ERROR("Unknown transition target %s.", name.c_str());
+            return false;
+        }
+        target = it->second;
+    }
+    return true;
+}
+//-----------------------------------------------------------------
+static bool parsePhaseGraph(XmlRpc::XmlRpcValue& g, const std::map<std::string, std::vector<double> >& joint_configurations,
+                            const std::vector<std::vector<double> >& place_zone_joints, unsigned int n_joints, PhaseGraph& graph)
+{
+    if(g.getType() != XmlRpc::XmlRpcValue::TypeArray || g.size() == 0)
+    {
+        ROS_ERROR("A phase graph has to be a non-empty list of phases.");
+        return false;
+    }
+
+    //the names first, so that transitions can point forward
+    std::map<std::string, int> phase_ids;
+    graph.phases_.resize(g.size());
+    for(int p=0; p<g.size(); p++)
+    {
+        if(g[p].getType() != XmlRpc::XmlRpcValue::TypeStruct || !g[p].hasMember("name") || !toString(g[p]["name"], graph.phases_[p].name_))
+        {
+            ROS_ERROR("Phase %d has no name.", p);
+            return false;
+        }
+        if(graph.phases_[p].name_ == "end" || graph.phases_[p].name_ == "abort" || !phase_ids.insert(std::make_pair(graph.phases_[p].name_, p)).second)
+        {
+            ROS_ERROR("Phase name %s is reserved or used twice.", graph.phases_[p].name_.c_str());
+            return false;
+        }
+    }
+
+    for(int p=0; p<g.size(); p++)
+    {
+        XmlRpc::XmlRpcValue& ph = g[p];
+        Phase& phase = graph.phases_[p];
+
+        std::string type = "tasks";
+        if(ph.hasMember("type") && !toString(ph["type"], type))
+        {
+            ROS_ERROR("Phase %s: the type has to be a string.", phase.name_.c_str());
+            return false;
+        }
+
+        phase.task_error_tol_ = 0.0;
+        phase.task_diff_tol_ = 1e-5;
+        phase.gripper_angle_ = 0.0;
+        phase.background_ = false;
+        if(type == "tasks")
+        {
+            phase.type_ = Phase::TASKS;
+            if(!ph.hasMember("tasks") || !parseTaskTemplate(ph["tasks"], joint_configurations, place_zone_joints, n_joints, phase.template_))
+            {
+                ROS_ERROR("Phase %s: invalid tasks.", phase.name_.c_str());
+                return false;
+            }
+            if(!ph.hasMember("task_error_tol") || !toDouble(ph["task_error_tol"], phase.task_error_tol_) ||
+               (ph.hasMember("task_diff_tol") && !toDouble(ph["task_diff_tol"], phase.task_diff_tol_)))
+            {
+                ROS_ERROR("Phase %s: needs a task_error_tol (and optionally a task_diff_tol).", phase.name_.c_str());
+                return false;
+            }
+        }
+        else if(type == "gripper_position")
+        {
+            phase.type_ = Phase::GRIPPER_POSITION;
+            if(!ph.hasMember("angle") || !toDouble(ph["angle"], phase.gripper_angle_))
+            {
+                ROS_ERROR("Phase %s: a gripper_position needs an angle.", phase.name_.c_str());
+                return false;
+            }
+            if(ph.hasMember("background") && !toBool(ph["background"], phase.background_))
+            {
+                ROS_ERROR("Phase %s: background has to be a bool.", phase.name_.c_str());
+                return false;
+            }
+        }
+        else if(type == "gripper_grasp")
+            phase.type_ = Phase::GRIPPER_GRASP;
+        else if(type == "switch_controllers")
+        {
+            phase.type_ = Phase::SWITCH_CONTROLLERS;
+            if((ph.hasMember("start") && !toStringArray(ph["start"], phase.start_controllers_)) ||
+               (ph.hasMember("stop") && !toStringArray(ph["stop"], phase.stop_controllers_)))
+            {
+                ROS_ERROR("Phase %s: start and stop have to be lists of controller names.", phase.name_.c_str());
+                return false;
+            }
+        }
+        else if(type == "truck_task")
+            phase.type_ = Phase::TRUCK_TASK;
+        else if(type == "reset")
+            phase.type_ = Phase::RESET;
+        else
+        {
+            ROS_ERROR("Phase %s: unknown type %s.", phase.name_.c_str(), type.c_str());
+            return false;
+        }
+
+        if(ph.hasMember("stiffness") && (!toDoubleArray(ph["stiffness"], phase.stiffness_) || phase.stiffness_.size() != 6))
+        {
+            ROS_ERROR("Phase %s: the stiffness needs 6 values (sx, sy, sz, sa, sb, sc).", phase.name_.c_str());
+            return false;
+        }
+
+        //TRANSITIONS
+        phase.next_ = (p + 1 < g.size()) ? p + 1 : PHASE_END;
+        phase.on_failure_ = PHASE_ABORT;
+        phase.loop_to_ = -1;
+        phase.loop_count_ = 0;
+        if((ph.hasMember("next") && !resolveTransition(ph["next"], phase_ids, phase.next_)) ||
+           (ph.hasMember("on_failure") && !resolveTransition(ph["on_failure"], phase_ids, phase.on_failure_)))
+        {
+            ROS_ERROR("Phase %s: invalid transition.", phase.name_.c_str());
+            return false;
+        }
+        if(ph.hasMember("loop_to"))
+        {
+            int loop_count;
+            if(!resolveTransition(ph["loop_to"], phase_ids, phase.loop_to_) || phase.loop_to_ < 0 ||
+               !ph.hasMember("loop_count") || !toInt(ph["loop_count"], loop_count) || loop_count < 1)
+            {
+                ROS_ERROR("Phase %s: loop_to needs a phase and a loop_count >= 1.", phase.name_.c_str());
+                return false;
+            }
+            phase.loop_count_ = loop_count;
+        }
+    }
+
+    graph.timing_.assign(graph.phases_.size(), PhaseTiming());
+    return true;
+}
+//-----------------------------------------------------------------
+bool loadPhaseGraphs(const ros::NodeHandle& n, const std::map<std::string, std::vector<double> >& joint_configurations,
+                     const std::vector<std::vector<double> >& place_zone_joints, unsigned int n_joints, std::vector<PhaseGraph>& graphs,
+                     std::vector<std::string>& invalid_graphs)
+{
+    //named joint configurations from the parameter server extend/override the built-in ones
+    std::map<std::string, std::vector<double> > configurations = joint_configurations;
+    XmlRpc::XmlRpcValue c;
+    if(n.getParam("joint_configurations", c))
+    {
+        if(c.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+        {
+            ROS_ERROR("joint_configurations has to be a map from names to joint values (namespace: %s).", n.getNamespace().c_str());
+            return false;
+        }
+        for(XmlRpc::XmlRpcValue::iterator it = c.begin(); it != c.end(); ++it)
+            if(!toDoubleArray(it->second, configurations[it->first]))
+            {
+                ROS_ERROR("Joint configuration %s has to be a list of numbers.", it->first.c_str());
+                return false;
+            }
+    }
+
+    XmlRpc::XmlRpcValue g;
+    if(!n.getParam("phase_graphs", g) || g.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+    {
+        ROS_ERROR("No phase_graphs map found (namespace: %s).", n.getNamespace().c_str());
+        return false;
+    }
+
+    graphs.clear();
+    invalid_graphs.clear();
+    for(XmlRpc::XmlRpcValue::iterator it = g.begin(); it != g.end(); ++it)
+    {
+        PhaseGraph graph;
+        graph.name_ = it->first;
+        if(!parsePhaseGraph(it->second, configurations, place_zone_joints, n_joints, graph))
+        {
+            ROS_ERROR("Could not load phase graph %s - skipping it.", graph.name_.c_str());
+            invalid_graphs.push_back(graph.name_);
+            continue;
+        }
+        graphs.push_back(graph);
+    }
+
+    return !graphs.empty();
+}
+//-----------------------------------------------------------------
+int successorPhase(PhaseGraph const& g, int p, std::vector<unsigned int>& loops)
+{
+    Phase const& phase = g.phases_[p];
+    if(phase.loop_to_ >= 0 && ++loops[p] < phase.loop_count_)
+        return phase.loop_to_;
+
+    loops[p] = 0;
+    return phase.next_;
+}
+//-----------------------------------------------------------------
+}//end namespace grasping_experiments
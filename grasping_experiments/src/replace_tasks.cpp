@@ -0,0 +1,116 @@
+#include <grasping_experiments/replace_tasks.h>
+#include <hqp_controllers_msgs/ActivateHQPControl.h>
+#include <hqp_controllers_msgs/RemoveTasks.h>
+#include <hqp_controllers_msgs/SetTasks.h>
+#include <hqp_controllers_msgs/VisualizeTaskGeometries.h>
+
+namespace grasping_experiments
+{
+//-----------------------------------------------------------------
+void HQPControlClients::init(ServiceClientPool& pool, ros::NodeHandle& n)
+{
+    activate_hqp_control_ = pool.serviceClient<hqp_controllers_msgs::ActivateHQPControl>(n, "activate_hqp_control", true);
+    remove_tasks_ = pool.serviceClient<hqp_controllers_msgs::RemoveTasks>(n, "remove_tasks");
+    set_tasks_ = pool.serviceClient<hqp_controllers_msgs::SetTasks>(n, "set_tasks");
+    visualize_task_geometries_ = pool.serviceClient<hqp_controllers_msgs::VisualizeTaskGeometries>(n, "visualize_task_geometries", true);
+}
+//-----------------------------------------------------------------
+bool replayReplaceTasks(HQPControlClients& clients, ReplaceTasks::Request const& req, ReplaceTasks::Response& res)
+{
+    res.ids.clear();
+    res.success = false;
+
+    if(req.deactivate)
+    {
+        hqp_controllers_msgs::ActivateHQPControl controller_status;
+        controller_status.request.active = false;
+        if(!clients.activate_hqp_control_.call(controller_status))
+        {
+            res.message = "could not deactivate the HQP control";
+            return false;
+        }
+    }
+
+    if(!req.remove_ids.empty())
+    {
+        hqp_controllers_msgs::RemoveTasks rem_t_srv;
+        rem_t_srv.request.ids = req.remove_ids;
+        if(!clients.remove_tasks_.call(rem_t_srv) || !rem_t_srv.response.success)
+        {
+            res.message = "could not remove tasks";
+            return false;
+        }
+    }
+
+    if(!req.tasks.empty())
+    {
+        hqp_controllers_msgs::SetTasks tasks;
+        tasks.request.tasks = req.tasks;
+        if(!clients.set_tasks_.call(tasks) || !tasks.response.success)
+        {
+            res.message = "could not set tasks";
+            return false;
+        }
+        res.ids = tasks.response.ids;
+    }
+
+    if(req.activate)
+    {
+        hqp_controllers_msgs::ActivateHQPControl controller_status;
+        controller_status.request.active = true;
+        if(!clients.activate_hqp_control_.call(controller_status))
+        {
+            res.message = "could not activate the HQP control";
+            return false;
+        }
+    }
+
+    if(!req.visualize_ids.empty() || !req.visualize_indices.empty())
+    {
+        hqp_controllers_msgs::VisualizeTaskGeometries vis_srv;
+        vis_srv.request.ids = req.visualize_ids;
+        for(unsigned int i=0; i<req.visualize_indices.size(); i++)
+        {
+            if(req.visualize_indices[i] >= res.ids.size())
+            {
+                res.message = "visualize index out of range";
+                return false;
+            }
+            vis_srv.request.ids.push_back(res.ids[req.visualize_indices[i]]);
+        }
+        if(!clients.visualize_task_geometries_.call(vis_srv) || !vis_srv.response.success)
+        {
+            res.message = "could not start visualization";
+            return false;
+        }
+    }
+
+    res.success = true;
+    return true;
+}
+//-----------------------------------------------------------------
+void ReplaceTasksClient::init(ServiceClientPool& pool, ros::NodeHandle& n, bool batch, ros::Duration const& timeout)
+{
+    single_.init(pool, n);
+    replace_tasks_clt_ = pool.serviceClient<ReplaceTasks>(n, "replace_tasks");
+
+    batched_ = batch && replace_tasks_clt_.waitForExistence(timeout);
+    if(batch && !batched_)
+        ROS_WARN("No replace_tasks service found (neither from the HQP controller nor from a replace_tasks_adapter node) - replaying transactions as single calls.");
+}
+//-----------------------------------------------------------------
+bool ReplaceTasksClient::call(ReplaceTasks& tx)
+{
+    if(!batched_)
+        return replayReplaceTasks(single_, tx.request, tx.response);
+
+    if(!replace_tasks_clt_.call(tx))
+    {
+        tx.response.success = false;
+        tx.response.message = "could not call replace_tasks";
+        return false;
+    }
+    return tx.response.success;
+}
+//-----------------------------------------------------------------
+}//end namespace grasping_experiments
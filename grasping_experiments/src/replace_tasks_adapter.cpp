@@ -0,0 +1,62 @@
+#include <grasping_experiments/replace_tasks.h>
+#include <boost/thread/mutex.hpp>
+
+/////////////////////////////////
+//   REPLACE TASKS ADAPTER     //
+/////////////////////////////////
+
+// Offers replace_tasks for HQP controllers which only have the single services (remap activate_hqp_control,
+// remove_tasks, set_tasks and visualize_task_geometries to the controller). Run it close to the controller, so the
+// replayed calls are local and the client pays a single round trip per transaction. The service is advertised in the
+// node's namespace rather than its private one, where ReplaceTasksClient finds it without a remap.
+
+namespace grasping_experiments
+{
+//-----------------------------------------------------------------
+class ReplaceTasksAdapter
+{
+public:
+
+    ReplaceTasksAdapter() : nh_("~")
+    {
+        bool persistent_services;
+        nh_.param<bool>("persistent_services", persistent_services, true);
+        pool_.init(persistent_services, 0.001, 2000);
+        clients_.init(pool_, n_);
+        replace_tasks_srv_ = n_.advertiseService("replace_tasks", &ReplaceTasksAdapter::replaceTasks, this);
+    }
+
+private:
+
+    ros::NodeHandle n_;
+    ros::NodeHandle nh_;
+    boost::mutex m_; ///< transactions must not interleave
+    ServiceClientPool pool_;
+    HQPControlClients clients_;
+    ros::ServiceServer replace_tasks_srv_;
+
+    bool replaceTasks(ReplaceTasks::Request& req, ReplaceTasks::Response& res)
+    {
+        boost::mutex::scoped_lock lock(m_);
+        if(!replayReplaceTasks(clients_, req, res))
+            ROS_ERROR("replace_tasks transaction failed: %s", res.message.c_str());
+
+        return true;
+    }
+};
+//-----------------------------------------------------------------
+}//end namespace grasping_experiments
+
+//---------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "replace_tasks_adapter");
+
+    grasping_experiments::ReplaceTasksAdapter adapter;
+
+    ROS_INFO("Replace tasks adapter ready");
+    ros::spin();
+
+    return 0;
+}
+//---------------------------------------------------------------------
@@ -0,0 +1,361 @@
+#include <grasping_experiments/grasping_experiments.h>
+
+namespace grasping_experiments
+{
+//-----------------------------------------------------------------
+bool GraspingExperiments::rejectPhaseGraph(std_srvs::Empty::Request  &req, std_srvs::Empty::Response &res, const std::string& graph)
+{
+    ROS_ERROR("Phase graph %s could not be loaded at startup, see the errors above - not running it.", graph.c_str());
+    return false;
+}
+//-----------------------------------------------------------------
+bool GraspingExperiments::runPhaseGraph(std_srvs::Empty::Request  &req, std_srvs::Empty::Response &res, unsigned int graph)
+{
+    PhaseGraph& g = phase_graphs_[graph];
+    std_srvs::Empty srv;
+    deactivateHQPControl();
+    resetState();
+    reset_hqp_control_clt_.call(srv);
+    pers_task_vis_ids_.clear();
+
+    if(!loadPersistentTasks())
+    {
+        ROS_ERROR("Could not load persistent tasks!");
+        safeShutdown();
+        return false;
+    }
+
+    std::vector<unsigned int> loops(g.phases_.size(), 0); ///< completed passes of each loop in this run
+    PhaseTaskSet next; ///< tasks built ahead for the next TASKS phase
+    ServiceCallFuture gripper; ///< gripper motion of a background phase
+    int gripper_phase = -1; ///< the background phase which started the gripper motion
+    int p = 0;
+    while(p >= 0 || (p == PHASE_END && gripper_phase >= 0))
+    {
+        //gripper phases and the end of the graph have to wait for a gripper motion in the background
+        if(gripper_phase >= 0 && (p < 0 || g.phases_[p].type_ == Phase::GRIPPER_POSITION || g.phases_[p].type_ == Phase::GRIPPER_GRASP))
+        {
+            int q = gripper_phase;
+            gripper_phase = -1;
+            if(!gripper.wait(service_timeout_))
+            {
+                ROS_ERROR("Phase graph %s: background phase %s failed.", g.name_.c_str(), g.phases_[q].name_.c_str());
+                next = PhaseTaskSet();
+                p = g.phases_[q].on_failure_;
+            }
+            continue;
+        }
+
+        Phase const& phase = g.phases_[p];
+        ROS_INFO("Phase graph %s: starting phase %s.", g.name_.c_str(), phase.name_.c_str());
+
+        ros::WallTime start = ros::WallTime::now();
+        ros::WallTime active;
+        double saved = 0.0;
+        bool success = true;
+
+        //a TASKS phase changes the stiffness while it uploads its tasks, the other phases need it before they start
+        ServiceCallFuture stiffness = setCartesianStiffnessAsync(phase.stiffness_);
+        if(phase.type_ == Phase::TASKS)
+            success = executeTaskPhase(g, p, loops, next, stiffness, active, saved);
+        else if(!stiffness.wait(service_timeout_))
+        {
+            ROS_ERROR("Could not set the stiffness of phase %s!", phase.name_.c_str());
+            success = false;
+        }
+        else if(phase.type_ == Phase::GRIPPER_POSITION && phase.background_)
+        {
+            gripper = moveGripperAsync(phase.gripper_angle_);
+            gripper_phase = p;
+        }
+        else
+            success = executeActionPhase(phase);
+        ros::WallTime end = ros::WallTime::now();
+        if(phase.type_ != Phase::TASKS || active.isZero())
+            active = end;
+
+        g.timing_[p].record((active - start).toSec(), (end - active).toSec(), saved);
+
+        if(!success)
+        {
+            ROS_ERROR("Phase graph %s: phase %s failed.", g.name_.c_str(), phase.name_.c_str());
+            next = PhaseTaskSet(); //built for the success path
+            p = phase.on_failure_;
+            continue;
+        }
+        ROS_INFO("Phase graph %s: phase %s completed (setup %f s, convergence %f s, saved %f s).", g.name_.c_str(), phase.name_.c_str(), (active - start).toSec(), (end - active).toSec(), saved);
+
+        p = successorPhase(g, p, loops);
+    }
+
+    reportPhaseTiming(g);
+    if(p == PHASE_ABORT)
+    {
+        safeShutdown();
+        return false;
+    }
+
+    deactivateHQPControl();
+    resetState();
+    reset_hqp_control_clt_.call(srv);
+    pers_task_vis_ids_.clear();
+
+    ROS_INFO("PHASE GRAPH %s FINISHED.", g.name_.c_str());
+
+    return true;
+}
+//-----------------------------------------------------------------
+bool GraspingExperiments::canPrebuild(Phase const& phase) const
+{
+    //the grasp interval has to be queried once the object can be sensed, i.e., when the phase is entered
+    return !(phase.template_.type_ == TaskTemplate::GRASP_APPROACH && phase.template_.query_grasp_interval_ && !with_gazebo_);
+}
+//-----------------------------------------------------------------
+bool GraspingExperiments::buildPhaseTasks(PhaseGraph const& g, int p, PhaseTaskSet& set)
+{
+    TaskTemplate const& task_template = g.phases_[p].template_;
+    ros::WallTime start = ros::WallTime::now();
+    bool success = false;
+
+    set = PhaseTaskSet();
+    switch(task_template.type_)
+    {
+    case TaskTemplate::JOINT_CONFIGURATION:
+        success = buildJointConfiguration(task_template.joints_, set);
+        break;
+
+    case TaskTemplate::GRASP_APPROACH:
+        if(task_template.query_grasp_interval_ && !with_gazebo_)
+            if(!getGraspInterval())
+                ROS_WARN("Could not obtain the grasp intervall - using default interval!");
+
+        success = buildGraspApproach(set);
+        break;
+
+    case TaskTemplate::OBJECT_EXTRACT:
+        success = buildObjectExtract(set);
+        break;
+
+    case TaskTemplate::OBJECT_PLACE:
+        success = buildObjectPlace(place_zones_[task_template.place_zone_], set);
+        break;
+
+    case TaskTemplate::GRIPPER_EXTRACT:
+        success = buildGripperExtract(place_zones_[task_template.place_zone_], set);
+        break;
+
+    case TaskTemplate::CUSTOM:
+        success = buildCustomTasks(task_template, set);
+        break;
+    }
+
+    set.phase_ = p;
+    set.build_time_ = (ros::WallTime::now() - start).toSec();
+    return success;
+}
+//-----------------------------------------------------------------
+bool GraspingExperiments::executeTaskPhase(PhaseGraph const& g, int p, std::vector<unsigned int> const& loops, PhaseTaskSet& next, ServiceCallFuture const& stiffness, ros::WallTime& active, double& saved)
+{
+    Phase const& phase = g.phases_[p];
+    PhaseTaskSet set;
+    saved = 0.0;
+    if(next.phase_ == p)
+    {
+        set = next;
+        saved = set.build_time_;
+    }
+    else if(!buildPhaseTasks(g, p, set))
+    {
+        ROS_ERROR("Could not build the tasks of phase %s!", phase.name_.c_str());
+        return false;
+    }
+    next = PhaseTaskSet();
+
+    boost::mutex::scoped_lock lock(manipulator_tasks_m_);
+    task_status_changed_ = false;
+    task_success_ = false;
+    task_error_tol_ = phase.task_error_tol_;
+    task_diff_tol_ = phase.task_diff_tol_;
+
+    if(replace_tasks_.batched())
+    {
+        //a single round trip, which also visualizes the tasks
+        if(!replaceStateTasks(set, stiffness))
+        {
+            ROS_ERROR("Could not replace the tasks of phase %s!", phase.name_.c_str());
+            return false;
+        }
+    }
+    else
+    {
+        deactivateHQPControl();
+        if(!resetState())
+        {
+            ROS_ERROR("Could not reset the state!");
+            return false;
+        }
+
+        if(!applyPhaseTasks(set))
+        {
+            ROS_ERROR("Could not set the tasks of phase %s!", phase.name_.c_str());
+            return false;
+        }
+
+        if(!pipeline_transitions_ && !visualizeStateTasks(phaseVisualizationIds(set)))
+            return false;
+
+        if(!stiffness.wait(service_timeout_))
+        {
+            ROS_ERROR("Could not set the stiffness of phase %s!", phase.name_.c_str());
+            return false;
+        }
+        activateHQPControl();
+    }
+    active = ros::WallTime::now();
+
+    ServiceCallFuture visualized;
+    if(pipeline_transitions_)
+    {
+        if(!replace_tasks_.batched())
+            visualized = async_.run(boost::bind(&GraspingExperiments::visualizeStateTasks, this, phaseVisualizationIds(set)));
+
+        //the rest overlaps with the convergence of the phase, so the status callback has to be able to complete it meanwhile
+        lock.unlock();
+
+        //follow the success transitions over action phases to the next TASKS phase
+        std::vector<unsigned int> l = loops;
+        int q = p;
+        for(unsigned int i=0; i<g.phases_.size(); i++)
+        {
+            q = successorPhase(g, q, l);
+            if(q < 0 || g.phases_[q].type_ == Phase::TASKS)
+                break;
+        }
+        if(q >= 0 && g.phases_[q].type_ == Phase::TASKS && canPrebuild(g.phases_[q]))
+            if(!buildPhaseTasks(g, q, next))
+                next = PhaseTaskSet(); //rebuilt when the phase is entered, which reports the error
+
+        lock.lock();
+    }
+
+    while(!task_status_changed_)
+        cond_.wait(lock);
+
+    if(visualized.valid())
+    {
+        if(!visualized.wait(service_timeout_))
+            return false;
+
+        saved += visualized.duration();
+    }
+
+    if(!task_success_)
+    {
+        ROS_ERROR("Could not complete the tasks of phase %s!", phase.name_.c_str());
+        return false;
+    }
+    return true;
+}
+//-----------------------------------------------------------------
+bool GraspingExperiments::executeActionPhase(Phase const& phase)
+{
+    switch(phase.type_)
+    {
+    case Phase::GRIPPER_POSITION:
+    {
+        if(!moveGripperAsync(phase.gripper_angle_).wait(service_timeout_))
+        {
+            ROS_ERROR("could not call velvet to pos");
+            return false;
+        }
+        return true;
+    }
+
+    case Phase::GRIPPER_GRASP:
+    {
+        if(with_gazebo_)
+            return true;
+
+        deactivateHQPControl();
+        velvet_interface_node::SmartGrasp graspcall;
+        graspcall.request.current_threshold_contact = 20;
+        graspcall.request.current_threshold_final = 35;
+        graspcall.request.max_belt_travel_mm = 90;
+        graspcall.request.phalange_delta_rad = 0.02;
+        graspcall.request.gripper_closed_thresh = 1.5;
+        graspcall.request.check_phalanges = true;
+
+        if(!velvet_grasp_clt_.call(graspcall))
+        {
+            ROS_ERROR("could not call grasping");
+            return false;
+        }
+        if(!graspcall.response.success)
+        {
+            ROS_ERROR("Grasp failed!");
+            return false;
+        }
+        ROS_INFO("Grasp aquired.");
+        return true;
+    }
+
+    case Phase::SWITCH_CONTROLLERS:
+    {
+        controller_manager_msgs::SwitchController msg;
+        msg.request.start_controllers = phase.start_controllers_;
+        msg.request.stop_controllers = phase.stop_controllers_;
+        msg.request.strictness = 2;
+        msg.response.ok = false;
+
+        deactivateHQPControl();
+        if(!switch_controller_clt_.call(msg) || !msg.response.ok)
+        {
+            ROS_ERROR("Could not switch the controllers!");
+            return false;
+        }
+        return true;
+    }
+
+    case Phase::TRUCK_TASK:
+    {
+        if(with_gazebo_)
+            return true;
+
+        std_srvs::Empty srv;
+        return next_truck_task_clt_.call(srv);
+    }
+
+    case Phase::RESET:
+    {
+        std_srvs::Empty srv;
+        deactivateHQPControl();
+        resetState();
+        reset_hqp_control_clt_.call(srv);
+        pers_task_vis_ids_.clear();
+        return true;
+    }
+
+    case Phase::TASKS:
+        break;
+    }
+    return false;
+}
+//-----------------------------------------------------------------
+void GraspingExperiments::reportPhaseTiming(PhaseGraph const& graph)
+{
+    ROS_INFO("Phase timing of graph %s (setup: until the HQP control is active, convergence: until the phase is completed, saved: dead time pipelined out of the transition):", graph.name_.c_str());
+    double saved = 0.0;
+    for(unsigned int p=0; p<graph.phases_.size(); p++)
+    {
+        PhaseTiming const& t = graph.timing_[p];
+        if(t.count_ == 0)
+            continue;
+
+        ROS_INFO("  %-32s runs: %4d  setup mean/max: %8.3f/%8.3f s  convergence mean/max: %8.3f/%8.3f s  saved mean/max: %8.3f/%8.3f s", graph.phases_[p].name_.c_str(), t.count_,
+                 t.setup_sum_ / t.count_, t.setup_max_, t.convergence_sum_ / t.count_, t.convergence_max_, t.saved_sum_ / t.count_, t.saved_max_);
+        saved += t.saved_sum_;
+    }
+    ROS_INFO("  total dead time saved: %f s", saved);
+}
+//-----------------------------------------------------------------
+} //end namespace
@@ -0,0 +1,153 @@
+#include <grasping_experiments/service_client_pool.h>
+#include <math.h>
+#include <sstream>
+#include <algorithm>
+
+namespace grasping_experiments
+{
+//-----------------------------------------------------------------
+PooledServiceClient::PooledServiceClient(boost::function<ros::ServiceClient()> const& connect, bool idempotent, double bin_width, unsigned int n_bins) : entry_(new Entry)
+{
+    entry_->connect_ = connect;
+    entry_->idempotent_ = idempotent;
+    entry_->client_ = connect();
+    entry_->service_ = entry_->client_.getService();
+    entry_->bin_width_ = bin_width;
+    entry_->histogram_.resize(std::max(n_bins, 1u), 0);
+}
+//-----------------------------------------------------------------
+bool PooledServiceClient::waitForExistence(ros::Duration timeout)
+{
+    if(!entry_)
+        return false;
+
+    //don't hold the lock, the connection is established on the first call
+    ros::ServiceClient client;
+    {
+        boost::mutex::scoped_lock lock(entry_->call_m_);
+        client = entry_->client_;
+    }
+    return client.waitForExistence(timeout);
+}
+//-----------------------------------------------------------------
+bool PooledServiceClient::exists()
+{
+    return waitForExistence(ros::Duration(0.0));
+}
+//-----------------------------------------------------------------
+std::string PooledServiceClient::getService() const
+{
+    if(!entry_)
+        return std::string();
+
+    return entry_->service_;
+}
+//-----------------------------------------------------------------
+void PooledServiceClient::reconnect()
+{
+    ROS_WARN("Reconnecting to service %s.", entry_->service_.c_str());
+    entry_->client_.shutdown();
+    entry_->client_ = entry_->connect_();
+
+    boost::mutex::scoped_lock lock(entry_->stats_m_);
+    entry_->reconnects_++;
+}
+//-----------------------------------------------------------------
+void PooledServiceClient::record(bool success, double latency)
+{
+    unsigned int n_bins = entry_->histogram_.size();
+    double b = floor(latency / entry_->bin_width_);
+    unsigned int bin = (b < n_bins - 1) ? ((b > 0.0) ? (unsigned int)b : 0) : n_bins - 1; //also catches NaN
+
+    boost::mutex::scoped_lock lock(entry_->stats_m_);
+    entry_->histogram_[bin]++;
+    entry_->calls_++;
+    entry_->latency_sum_ += latency;
+    entry_->latency_max_ = std::max(entry_->latency_max_, latency);
+    entry_->last_failed_ = !success;
+    if(!success)
+        entry_->failures_++;
+}
+//-----------------------------------------------------------------
+//upper edge of the first bin at which the cumulated count reaches the percentile
+static double percentile(std::vector<boost::uint64_t> const& histogram, boost::uint64_t count, double bin_width, double p)
+{
+    if(count == 0)
+        return 0.0;
+
+    boost::uint64_t threshold = (boost::uint64_t)ceil(p * count);
+    boost::uint64_t sum = 0;
+    for(unsigned int i=0; i<histogram.size(); i++)
+    {
+        sum += histogram[i];
+        if(sum >= threshold)
+            return (i + 1) * bin_width;
+    }
+    return histogram.size() * bin_width;
+}
+//-----------------------------------------------------------------
+template<class T>
+static void addValue(diagnostic_msgs::DiagnosticStatus& status, std::string const& key, T value)
+{
+    diagnostic_msgs::KeyValue kv;
+    std::ostringstream s;
+    s<<value;
+    kv.key = key;
+    kv.value = s.str();
+    status.values.push_back(kv);
+}
+//-----------------------------------------------------------------
+void PooledServiceClient::getStatus(diagnostic_msgs::DiagnosticStatus& status) const
+{
+    //not the call mutex, a blocking call must not hold up the diagnostics (and the pool mutex held meanwhile)
+    boost::mutex::scoped_lock lock(entry_->stats_m_);
+
+    status.name = "service " + entry_->service_;
+    status.hardware_id = entry_->service_;
+    status.level = entry_->last_failed_ ? (unsigned char)diagnostic_msgs::DiagnosticStatus::WARN : (unsigned char)diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = entry_->last_failed_ ? "last call failed" : "ok";
+    status.values.clear();
+
+    addValue(status, "calls", entry_->calls_);
+    addValue(status, "failures", entry_->failures_);
+    addValue(status, "reconnects", entry_->reconnects_);
+    addValue(status, "latency mean [ms]", (entry_->calls_ > 0) ? 1e3 * entry_->latency_sum_ / entry_->calls_ : 0.0);
+    addValue(status, "latency p50 [ms]", 1e3 * percentile(entry_->histogram_, entry_->calls_, entry_->bin_width_, 0.5));
+    addValue(status, "latency p99 [ms]", 1e3 * percentile(entry_->histogram_, entry_->calls_, entry_->bin_width_, 0.99));
+    addValue(status, "latency max [ms]", 1e3 * entry_->latency_max_);
+    addValue(status, "histogram bin width [ms]", 1e3 * entry_->bin_width_);
+
+    //only up to the last non-empty bin
+    unsigned int n = entry_->histogram_.size();
+    while(n > 0 && entry_->histogram_[n - 1] == 0)
+        n--;
+
+    std::ostringstream s;
+    for(unsigned int i=0; i<n; i++)
+        s<<(i > 0 ? " " : "")<<entry_->histogram_[i];
+
+    diagnostic_msgs::KeyValue kv;
+    kv.key = "histogram";
+    kv.value = s.str();
+    status.values.push_back(kv);
+}
+//-----------------------------------------------------------------
+void ServiceClientPool::init(bool persistent, double bin_width, unsigned int n_bins)
+{
+    ROS_ASSERT(bin_width > 0.0);
+    persistent_ = persistent;
+    bin_width_ = bin_width;
+    n_bins_ = n_bins;
+}
+//-----------------------------------------------------------------
+void ServiceClientPool::getDiagnostics(diagnostic_msgs::DiagnosticArray& diagnostics) const
+{
+    boost::mutex::scoped_lock lock(m_);
+
+    diagnostics.header.stamp = ros::Time::now();
+    diagnostics.status.resize(clients_.size());
+    for(unsigned int i=0; i<clients_.size(); i++)
+        clients_[i].getStatus(diagnostics.status[i]);
+}
+//-----------------------------------------------------------------
+}//end namespace grasping_experiments
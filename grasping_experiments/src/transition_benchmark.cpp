@@ -0,0 +1,115 @@
+#include <grasping_experiments/replace_tasks.h>
+#include <algorithm>
+#include <sstream>
+
+/////////////////////////////////
+//    TRANSITION BENCHMARK     //
+/////////////////////////////////
+
+// Times phase transitions (deactivate, remove, set, activate, visualize) against an HQP controller or the
+// hqp_controller_stand_in: first replayed as single calls, then as one replace_tasks transaction if the service exists.
+// Parameters: ~transitions (default 100), ~tasks per phase (default 10), ~persistent_services (default true).
+
+namespace grasping_experiments
+{
+//-----------------------------------------------------------------
+static void printLatencies(std::string const& mode, std::vector<double> latencies)
+{
+    if(latencies.empty())
+        return;
+
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0.0;
+    for(unsigned int i=0; i<latencies.size(); i++)
+        sum += latencies[i];
+
+    ROS_INFO("%-12s transitions: %4d  mean: %8.3f ms  p50: %8.3f ms  p99: %8.3f ms  max: %8.3f ms", mode.c_str(), (int)latencies.size(),
+             1e3 * sum / latencies.size(), 1e3 * latencies[latencies.size() / 2], 1e3 * latencies[(latencies.size() * 99) / 100], 1e3 * latencies.back());
+}
+//-----------------------------------------------------------------
+/**Runs n_transitions transitions between task sets of n_tasks tasks through client, returns false if one failed*/
+static bool runTransitions(ReplaceTasksClient& client, unsigned int n_transitions, unsigned int n_tasks, std::vector<double>& latencies)
+{
+    ReplaceTasks tx;
+    tx.request.deactivate = true;
+    tx.request.activate = true;
+    for(unsigned int i=0; i<n_tasks; i++)
+    {
+        hqp_controllers_msgs::Task task;
+        std::ostringstream name;
+        name<<"transition_benchmark_task_"<<i;
+        task.name = name.str();
+        task.t_type = hqp_controllers_msgs::Task::JOINT_SETPOINT;
+        task.priority = 2;
+        task.is_equality_task = true;
+        task.task_frame = "world";
+        tx.request.tasks.push_back(task);
+        tx.request.visualize_indices.push_back(i);
+    }
+
+    std::vector<unsigned int> ids;
+    latencies.clear();
+    for(unsigned int t=0; t<=n_transitions && ros::ok(); t++)
+    {
+        tx.request.remove_ids = ids;
+        ros::WallTime start = ros::WallTime::now();
+        if(!client.call(tx))
+        {
+            ROS_ERROR("Transition %d failed: %s", t, tx.response.message.c_str());
+            return false;
+        }
+        //the first transition only sets the initial tasks
+        if(t > 0)
+            latencies.push_back((ros::WallTime::now() - start).toSec());
+
+        ids = tx.response.ids;
+    }
+
+    //leave the controller empty and inactive
+    tx.request.remove_ids = ids;
+    tx.request.tasks.clear();
+    tx.request.visualize_indices.clear();
+    tx.request.activate = false;
+    return client.call(tx);
+}
+//-----------------------------------------------------------------
+}//end namespace grasping_experiments
+
+//---------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "transition_benchmark");
+    ros::NodeHandle n;
+    ros::NodeHandle nh("~");
+
+    int n_transitions, n_tasks;
+    nh.param<int>("transitions", n_transitions, 100);
+    nh.param<int>("tasks", n_tasks, 10);
+    if(n_transitions < 1 || n_tasks < 1)
+    {
+        ROS_ERROR("transitions and tasks have to be positive.");
+        return 1;
+    }
+
+    bool persistent_services;
+    nh.param<bool>("persistent_services", persistent_services, true);
+    grasping_experiments::ServiceClientPool pool;
+    pool.init(persistent_services, 0.001, 2000);
+
+    std::vector<double> single, batched;
+    grasping_experiments::ReplaceTasksClient single_clt;
+    single_clt.init(pool, n, false, ros::Duration(0.0));
+    if(!grasping_experiments::runTransitions(single_clt, n_transitions, n_tasks, single))
+        return 1;
+
+    grasping_experiments::ReplaceTasksClient batched_clt;
+    batched_clt.init(pool, n, true, ros::Duration(5.0));
+    if(batched_clt.batched() && !grasping_experiments::runTransitions(batched_clt, n_transitions, n_tasks, batched))
+        return 1;
+
+    grasping_experiments::printLatencies("single calls", single);
+    grasping_experiments::printLatencies("transaction", batched);
+
+    return 0;
+}
+//---------------------------------------------------------------------
@@ -0,0 +1,98 @@
+#ifndef CONTROLLER_TELEMETRY_H
+#define CONTROLLER_TELEMETRY_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <Eigen/Core>
+#include <ros/node_handle.h>
+#include <boost/thread/thread.hpp>
+#include <boost/noncopyable.hpp>
+#include <group_effort_controllers/realtime_ring_buffer.h>
+#include <group_effort_controllers/JointGroupTelemetry.h>
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief One control cycle of a joint group.
+   */
+struct TelemetryRecord
+{
+    ros::Time stamp_;
+    double time_step_;
+    Eigen::ArrayXd set_point_;
+    Eigen::ArrayXd process_value_;
+    Eigen::ArrayXd error_;
+    Eigen::ArrayXd command_;
+};
+//--------------------------------------------------------
+/**
+   * \brief Lossless full-rate recording of the controller state.
+   *
+   * The real-time thread stores one TelemetryRecord per cycle in a preallocated ring buffer, a drain
+   * thread periodically empties the buffer and either publishes the records in batches as
+   * JointGroupTelemetry messages or appends them to a binary log file.
+   *
+   * The binary file starts with the 4 characters "GECT", a uint32 format version (1), a uint32 joint count n
+   * and the n joint names, each as uint32 length followed by the characters. Each record then consists of
+   * 2 + 4n doubles: stamp, time step, set points, process values, errors and commands.
+   */
+class ControllerTelemetry : boost::noncopyable
+{
+public:
+
+    enum Output { OUTPUT_NONE, OUTPUT_TOPIC, OUTPUT_FILE };
+
+    ControllerTelemetry();
+    ~ControllerTelemetry();
+
+    /**Reads the parameters in the "telemetry" sub-namespace of n, allocates the ring buffer and starts the drain thread. Also returns true if telemetry is disabled.*/
+    bool init(ros::NodeHandle& n, const std::vector<std::string>& joint_names);
+
+    bool isEnabled() const { return output_ != OUTPUT_NONE; }
+
+    /**Real-time safe. Stores one cycle, the record is dropped if the ring buffer is full.*/
+    void record(const ros::Time& stamp, double time_step, const Eigen::Ref<const Eigen::VectorXd>& set_point, const Eigen::Ref<const Eigen::ArrayXd>& process_value,
+                const Eigen::Ref<const Eigen::ArrayXd>& error, const Eigen::Ref<const Eigen::ArrayXd>& command)
+    {
+        TelemetryRecord* rec = buffer_.acquire();
+        if(!rec)
+            return;
+
+        rec->stamp_ = stamp;
+        rec->time_step_ = time_step;
+        rec->set_point_ = set_point.array();
+        rec->process_value_ = process_value;
+        rec->error_ = error;
+        rec->command_ = command;
+        buffer_.commit();
+    }
+
+    /**Stops the drain thread after flushing the remaining records.*/
+    void stop();
+
+private:
+
+    void drain();
+    void flush();
+    void publishRecords();
+    void writeRecords();
+
+    Output output_;
+    unsigned int n_joints_;
+    double drain_rate_;
+    RealtimeRingBuffer<TelemetryRecord> buffer_;
+    boost::thread drain_thread_;
+
+    ros::Publisher telemetry_pub_;
+    JointGroupTelemetry msg_;
+    unsigned int max_batch_size_;
+
+    std::ofstream file_;
+    std::vector<double> file_record_;
+};
+
+} //end namespace group_effort_controllers
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef CYCLE_MONITOR_H
+#define CYCLE_MONITOR_H
+
+#include <time.h>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/noncopyable.hpp>
+#include <group_effort_controllers/CycleStatistics.h>
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief Collects execution time and period jitter statistics of a real-time loop.
+   *
+   * All storage is allocated in init(...). record(...) is meant to be called from the real-time thread only
+   * (single writer) and does nothing but relaxed stores on atomic counters. getStatistics(...) can be called
+   * from any other thread to obtain a (slightly non-atomic) snapshot.
+   */
+class CycleMonitor : boost::noncopyable
+{
+public:
+
+    CycleMonitor();
+
+    /**Allocates the histograms. nominal_period is the expected loop period, cycles taking longer than budget to execute count as overruns.*/
+    void init(double nominal_period, double budget, double bin_width, unsigned int n_bins);
+
+    /**Real-time safe. Records one cycle which took exec_time seconds to execute and was started period seconds after the previous one.*/
+    void record(double exec_time, double period);
+
+    /**Fills the statistics message, the message arrays are resized - don't call from the real-time thread.*/
+    void getStatistics(CycleStatistics& stats) const;
+
+    /**Current value of a monotonic clock in seconds, real-time safe.*/
+    static double now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + 1e-9 * ts.tv_nsec;
+    }
+
+private:
+
+    typedef boost::atomic<boost::uint64_t> Counter;
+
+    static void increment(Counter& c) { c.store(c.load(boost::memory_order_relaxed) + 1, boost::memory_order_relaxed); }
+    unsigned int bin(double value) const;
+    double percentile(const boost::scoped_array<Counter>& histogram, boost::uint64_t count, double p) const;
+
+    double nominal_period_;
+    double budget_;
+    double bin_width_;
+    unsigned int n_bins_;
+
+    boost::scoped_array<Counter> exec_time_histogram_;
+    boost::scoped_array<Counter> jitter_histogram_;
+    Counter cycles_;
+    Counter overruns_;
+    Counter missed_cycles_;
+    Counter exec_time_sum_ns_;
+    Counter exec_time_max_ns_;
+    Counter jitter_max_ns_;
+};
+
+} //end namespace group_effort_controllers
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef DISTURBANCE_OBSERVER_H
+#define DISTURBANCE_OBSERVER_H
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <Eigen/Core>
+#include <ros/node_handle.h>
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief Disturbance observer for a group of velocity controlled joints.
+   *
+   * Each joint is modelled as a nominal inertia J driven by the applied effort tau and a disturbance d (contacts,
+   * payloads, friction, model errors), i.e., J dv/dt = tau + d. The disturbance is estimated as
+   * d_hat = Q(s) (J s v - tau) with the first order low-pass Q(s) = g/(s+g). The estimate is computed as
+   * d_hat = g J v - w, with w = Q(s) (g J v + tau), so that the measured velocity is never differentiated. Subtracting
+   * d_hat from the efforts rejects load changes within about 1/g seconds, without waiting for the integrator.
+   */
+template <int N = Eigen::Dynamic>
+class DisturbanceObserver
+{
+public:
+
+    typedef Eigen::Array<double, N, 1> ArrayN;
+
+    DisturbanceObserver() : enabled_(false), cutoff_(10.0), max_compensation_(0.0), dt_(0.0), alpha_(0.0) {}
+
+    /**Reads the parameters from the "disturbance_observer" sub-namespace of n. Also returns true if the observer is disabled.*/
+    bool init(const ros::NodeHandle& n, const std::vector<std::string>& joint_names)
+    {
+        ros::NodeHandle o_n(n, "disturbance_observer");
+        o_n.param("enabled", enabled_, false);
+        estimate_.setZero(joint_names.size());
+        if(!enabled_)
+            return true;
+
+        std::vector<double> inertia;
+        o_n.param("cutoff", cutoff_, 10.0);
+        o_n.param("max_compensation", max_compensation_, 0.0);
+        if(!o_n.getParam("inertia", inertia) || inertia.size() != joint_names.size())
+        {
+            ROS_ERROR("The disturbance observer needs a nominal inertia for each joint, ordered as the joints parameter (namespace: %s).", o_n.getNamespace().c_str());
+            return false;
+        }
+        if(cutoff_ <= 0.0 || max_compensation_ < 0.0)
+        {
+            ROS_ERROR("Invalid disturbance observer parameters - need cutoff > 0 and max_compensation >= 0 (namespace: %s).", o_n.getNamespace().c_str());
+            return false;
+        }
+
+        inertia_.resize(joint_names.size());
+        for(unsigned int i=0; i<joint_names.size(); i++)
+            inertia_(i) = inertia[i];
+        filtered_.setZero(joint_names.size());
+
+        return true;
+    }
+
+    bool isEnabled() const { return enabled_; }
+
+    /**Starts with a zero estimate at the given velocities.*/
+    void reset(const ArrayN& velocities)
+    {
+        if(!enabled_)
+            return;
+
+        filtered_ = cutoff_ * 2.0 * M_PI * inertia_ * velocities;
+        estimate_.setZero();
+    }
+
+    /**Starts at the given velocities with the given estimate (clamped to max_compensation), e.g., the negated holding efforts for a bumpless start.*/
+    template <class Derived>
+    void reset(const ArrayN& velocities, const Eigen::ArrayBase<Derived>& estimate)
+    {
+        if(!enabled_)
+            return;
+
+        estimate_ = estimate;
+        if(max_compensation_ > 0.0)
+            estimate_ = estimate_.max(-max_compensation_).min(max_compensation_);
+        filtered_ = cutoff_ * 2.0 * M_PI * inertia_ * velocities - estimate_;
+    }
+
+    /**Real-time safe. Updates the estimate with the current velocities and the efforts applied during the last time step dt.*/
+    const ArrayN& update(const ArrayN& velocities, const ArrayN& efforts, double dt)
+    {
+        if(!enabled_ || !(dt > 0.0))
+            return estimate_;
+
+        double g = 2.0 * M_PI * cutoff_;
+        if(dt != dt_)
+        {
+            dt_ = dt;
+            alpha_ = 1.0 - std::exp(-g * dt);
+        }
+
+        filtered_ += alpha_ * (g * inertia_ * velocities + efforts - filtered_);
+        estimate_ = g * inertia_ * velocities - filtered_;
+        if(max_compensation_ > 0.0)
+            estimate_ = estimate_.max(-max_compensation_).min(max_compensation_);
+
+        return estimate_;
+    }
+
+    /**The disturbance efforts estimated in the last update(...), to be subtracted from the commanded efforts.*/
+    const ArrayN& getEstimate() const { return estimate_; }
+
+private:
+
+    bool enabled_;
+    double cutoff_; ///< cutoff frequency of the Q-filter in Hz
+    double max_compensation_; ///< bound on the magnitude of the estimate, 0 means unbounded
+    double dt_; ///< time step alpha_ was computed for
+    double alpha_;
+
+    ArrayN inertia_; ///< nominal inertia of each joint
+    ArrayN filtered_; ///< w = Q(s) (g J v + tau)
+    ArrayN estimate_;
+};
+
+} //end namespace group_effort_controllers
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <vector>
+#include <string>
+#include <Eigen/Core>
+#include <boost/cstdint.hpp>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace group_effort_controllers
+{
+#define FLIGHT_RECORDER_MAGIC "GEFR"
+#define FLIGHT_RECORDER_VERSION 1
+#define FLIGHT_RECORDER_NAME_LENGTH 64 //bytes reserved per joint name
+#define FLIGHT_RECORDER_FIELDS 7 //doubles per joint and record
+//--------------------------------------------------------
+/**
+   * \brief Layout of the flight recorder file header.
+   *
+   * The header is followed by n_joints_ zero-padded joint names of FLIGHT_RECORDER_NAME_LENGTH bytes and, starting at
+   * data_offset_, capacity_ records of record_size_ doubles. Each record holds the stamp and time step of the cycle,
+   * followed by FLIGHT_RECORDER_FIELDS blocks of n_joints_ values: set points, velocities, measured efforts,
+   * commanded efforts and the P, I and D terms. The records form a ring - record k is stored at index k % capacity_ and
+   * count_ is the number of records written so far.
+   */
+struct FlightRecorderHeader
+{
+    char magic_[4];
+    boost::uint32_t version_;
+    boost::uint32_t n_joints_;
+    boost::uint32_t record_size_;
+    boost::uint64_t capacity_;
+    boost::uint64_t data_offset_;
+    boost::uint64_t count_;
+};
+//--------------------------------------------------------
+/**
+   * \brief Records the last capacity control cycles in shared memory and dumps them to a file.
+   *
+   * The ring is kept in a POSIX shared memory object (/dev/shm/<getSharedMemoryName()> on Linux), which is created,
+   * sized and mapped (with all pages touched and locked) in open(...). Shared memory is never written back to a disk,
+   * so the plain stores in record(...) can't hit a page fault - a mapped regular file would be write-protected again
+   * each time the kernel writes its dirty pages back. The object outlives the process, so after a crash the last
+   * cycles can be read from /dev/shm. dump() copies the ring to the file given in open(...) outside of the real-time
+   * loop, close() dumps a last time and removes the shared memory object. Both the file and the shared memory object
+   * can be inspected with the flight_recorder_to_csv tool.
+   */
+class FlightRecorder : boost::noncopyable
+{
+public:
+
+    FlightRecorder();
+    ~FlightRecorder();
+
+    /**Creates (or truncates) the shared memory object for file_name and maps it. On failure, the reason can be retrieved with getError().*/
+    bool open(const std::string& file_name, const std::vector<std::string>& joint_names, boost::uint64_t capacity);
+    /**Dumps the ring and removes the shared memory object.*/
+    void close();
+
+    /**Not real-time safe, may run concurrently to record(...). Replaces the file with the records which are complete in
+     * the snapshot of the ring, in a file of the same format. Returns false if the file can't be written.*/
+    bool dump();
+
+    bool isOpen() const { return header_ != NULL; }
+    const std::string& getError() const { return error_; }
+    /**Name of the shared memory object, derived from the file name so that it is found again after a crash.*/
+    const std::string& getSharedMemoryName() const { return shm_name_; }
+
+    /**Real-time safe. Overwrites the oldest record once the file is full.*/
+    template <class SetPoint>
+    void record(double stamp, double time_step, const Eigen::MatrixBase<SetPoint>& set_point, const Eigen::Ref<const Eigen::ArrayXd>& velocity,
+                const Eigen::Ref<const Eigen::ArrayXd>& effort, const Eigen::Ref<const Eigen::ArrayXd>& command, const Eigen::Ref<const Eigen::ArrayXd>& p_term,
+                const Eigen::Ref<const Eigen::ArrayXd>& i_term, const Eigen::Ref<const Eigen::ArrayXd>& d_term)
+    {
+        boost::uint64_t count = header_->count_;
+        double* rec = data_ + (count % header_->capacity_) * header_->record_size_;
+        unsigned int n = header_->n_joints_;
+
+        rec[0] = stamp;
+        rec[1] = time_step;
+        Eigen::Map<Eigen::ArrayXd>(rec + 2, n) = set_point.array();
+        Eigen::Map<Eigen::ArrayXd>(rec + 2 + n, n) = velocity;
+        Eigen::Map<Eigen::ArrayXd>(rec + 2 + 2 * n, n) = effort;
+        Eigen::Map<Eigen::ArrayXd>(rec + 2 + 3 * n, n) = command;
+        Eigen::Map<Eigen::ArrayXd>(rec + 2 + 4 * n, n) = p_term;
+        Eigen::Map<Eigen::ArrayXd>(rec + 2 + 5 * n, n) = i_term;
+        Eigen::Map<Eigen::ArrayXd>(rec + 2 + 6 * n, n) = d_term;
+
+        //make sure the record is complete before it is counted
+        boost::atomic_thread_fence(boost::memory_order_release);
+        header_->count_ = count + 1;
+    }
+
+private:
+
+    std::string error_;
+    std::string file_name_;
+    std::string shm_name_;
+    int fd_;
+    void* map_;
+    size_t map_size_;
+    FlightRecorderHeader* header_;
+    double* data_;
+    std::vector<double> snapshot_; ///< copy of the records taken by dump(), allocated in open(...)
+};
+
+} //end namespace group_effort_controllers
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef GAIN_SCHEDULE_H
+#define GAIN_SCHEDULE_H
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Core>
+#include <ros/node_handle.h>
+
+namespace group_effort_controllers
+{
+#define GAIN_SCHEDULE_MAX_KEYS 3 //maximum number of joints spanning the schedule table
+//--------------------------------------------------------
+/**
+   * \brief Configuration dependent scaling of the PID gains of a group of joints.
+   *
+   * The table is defined on a uniform grid over the positions of a few key joints (e.g., the shoulder and elbow
+   * joints, whose positions dominate the effective inertia of the arm). Each grid point holds a factor per scheduled
+   * joint, the factors at the current configuration are interpolated multilinearly between the surrounding grid points
+   * and clamped at the border of the grid. Since the grid is uniform, the cell is found in constant time. Joints without
+   * table keep a factor of 1.
+   */
+template <int N = Eigen::Dynamic>
+class GainSchedule
+{
+public:
+
+    typedef Eigen::Array<double, N, 1> ArrayN;
+
+    GainSchedule() : n_keys_(0), n_grid_points_(0) {}
+
+    /**Reads the table from the "gain_schedule" sub-namespace of n. Also returns true if there is no schedule.*/
+    bool init(const ros::NodeHandle& n, const std::vector<std::string>& joint_names)
+    {
+        ros::NodeHandle s_n(n, "gain_schedule");
+        factors_.setOnes(joint_names.size());
+        n_keys_ = 0;
+
+        std::vector<std::string> keys;
+        if(!s_n.getParam("keys", keys) || keys.empty())
+            return true;
+
+        std::vector<double> min, max;
+        std::vector<int> n_points;
+        if(keys.size() > GAIN_SCHEDULE_MAX_KEYS || !s_n.getParam("min", min) || !s_n.getParam("max", max) || !s_n.getParam("n_points", n_points)
+           || min.size() != keys.size() || max.size() != keys.size() || n_points.size() != keys.size())
+        {
+            ROS_ERROR("The gain schedule needs at most %d keys and min, max and n_points for each of them (namespace: %s).", GAIN_SCHEDULE_MAX_KEYS, s_n.getNamespace().c_str());
+            return false;
+        }
+
+        //GRID
+        n_grid_points_ = 1;
+        for(unsigned int k=keys.size(); k-- > 0;) //the last key varies fastest in the table
+        {
+            std::vector<std::string>::const_iterator it = std::find(joint_names.begin(), joint_names.end(), keys[k]);
+            if(it == joint_names.end() || n_points[k] < 1 || (n_points[k] > 1 && !(max[k] > min[k])))
+            {
+                ROS_ERROR("Invalid gain schedule key %s - it has to be a joint of the group with max > min and n_points >= 1 (namespace: %s).", keys[k].c_str(), s_n.getNamespace().c_str());
+                return false;
+            }
+            key_index_[k] = it - joint_names.begin();
+            min_[k] = min[k];
+            n_points_[k] = n_points[k];
+            step_[k] = (n_points[k] > 1) ? (max[k] - min[k]) / (n_points[k] - 1) : 1.0;
+            stride_[k] = n_grid_points_;
+            n_grid_points_ *= n_points[k];
+        }
+
+        //TABLES
+        std::vector<std::vector<double> > tables;
+        scheduled_.clear();
+        for(unsigned int j=0; j<joint_names.size(); j++)
+        {
+            std::vector<double> table;
+            if(!s_n.getParam("factors/" + joint_names[j], table))
+                continue;
+
+            if(table.size() != n_grid_points_)
+            {
+                ROS_ERROR("The gain schedule of joint %s has %d entries, but the grid has %d points (namespace: %s).", joint_names[j].c_str(), (int)table.size(), n_grid_points_, s_n.getNamespace().c_str());
+                return false;
+            }
+            scheduled_.push_back(j);
+            tables.push_back(table);
+        }
+        if(scheduled_.empty())
+        {
+            ROS_ERROR("The gain schedule has keys, but no factors for any joint (namespace: %s).", s_n.getNamespace().c_str());
+            return false;
+        }
+
+        table_.resize(scheduled_.size(), n_grid_points_);
+        for(unsigned int s=0; s<scheduled_.size(); s++)
+            for(unsigned int g=0; g<n_grid_points_; g++)
+                table_(s, g) = tables[s][g];
+        scheduled_factors_.setZero(scheduled_.size());
+
+        n_keys_ = keys.size();
+        return true;
+    }
+
+    bool isEnabled() const { return n_keys_ > 0; }
+
+    /**Real-time safe. Returns the gain factors of all joints at the given joint positions, valid until the next call.*/
+    const ArrayN& evaluate(const ArrayN& positions)
+    {
+        if(!isEnabled())
+            return factors_;
+
+        unsigned int cell[GAIN_SCHEDULE_MAX_KEYS];
+        double weight[GAIN_SCHEDULE_MAX_KEYS];
+        for(unsigned int k=0; k<n_keys_; k++)
+        {
+            double x = std::max(0.0, std::min((positions(key_index_[k]) - min_[k]) / step_[k], (double)(n_points_[k] - 1)));
+            cell[k] = std::min((unsigned int)x, n_points_[k] - 1);
+            weight[k] = x - cell[k];
+        }
+
+        //blend the 2^n_keys corners of the cell
+        scheduled_factors_.setZero();
+        for(unsigned int c=0; c < (1u << n_keys_); c++)
+        {
+            unsigned int index = 0;
+            double w = 1.0;
+            for(unsigned int k=0; k<n_keys_; k++)
+            {
+                bool upper = c & (1u << k);
+                index += std::min(cell[k] + upper, n_points_[k] - 1) * stride_[k];
+                w *= upper ? weight[k] : 1.0 - weight[k];
+            }
+            if(w > 0.0)
+                scheduled_factors_ += w * table_.col(index);
+        }
+
+        for(unsigned int s=0; s<scheduled_.size(); s++)
+            factors_(scheduled_[s]) = scheduled_factors_(s);
+
+        return factors_;
+    }
+
+private:
+
+    unsigned int n_keys_;
+    unsigned int key_index_[GAIN_SCHEDULE_MAX_KEYS]; ///< index of each key joint in the group
+    double min_[GAIN_SCHEDULE_MAX_KEYS];
+    double step_[GAIN_SCHEDULE_MAX_KEYS]; ///< grid spacing of each key
+    unsigned int n_points_[GAIN_SCHEDULE_MAX_KEYS];
+    unsigned int stride_[GAIN_SCHEDULE_MAX_KEYS]; ///< distance of neighbouring grid points of each key in the table
+    unsigned int n_grid_points_;
+
+    std::vector<unsigned int> scheduled_; ///< index of each scheduled joint in the group
+    Eigen::MatrixXd table_; ///< one row per scheduled joint, one column per grid point
+    Eigen::VectorXd scheduled_factors_;
+    ArrayN factors_;
+};
+
+} //end namespace group_effort_controllers
+
+#endif
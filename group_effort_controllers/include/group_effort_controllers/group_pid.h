@@ -0,0 +1,172 @@
+#ifndef GROUP_PID_H
+#define GROUP_PID_H
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <Eigen/Core>
+#include <ros/node_handle.h>
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief PID controller for a group of joints.
+   *
+   * Gains, integrator states and previous errors are stored in contiguous Eigen arrays so that the
+   * command for all joints is computed in one vectorized pass. N is the number of joints, or
+   * Eigen::Dynamic if it is only known at runtime (storage is allocated once in init(...) then).
+   *
+   * Unlike control_toolbox::Pid, the integral term itself (i.e., i*sum(e*dt)) is integrated and
+   * clamped to [i_clamp_min, i_clamp_max], which prevents windup and keeps the effort continuous
+   * when the i gain is changed.
+   */
+template <int N = Eigen::Dynamic>
+class GroupPid
+{
+public:
+
+    typedef Eigen::Array<double, N, 1> ArrayN;
+
+    struct Gains
+    {
+        ArrayN p_;
+        ArrayN i_;
+        ArrayN d_;
+        ArrayN i_min_;
+        ArrayN i_max_;
+
+        void resize(unsigned int n_joints)
+        {
+            p_.setZero(n_joints); i_.setZero(n_joints); d_.setZero(n_joints);
+            i_min_.setZero(n_joints); i_max_.setZero(n_joints);
+        }
+    };
+
+    GroupPid() : n_joints_(0) {}
+
+    /**Reads the gains for each joint from the "pid_<joint name>" namespace (parameters p, i, d, i_clamp_min, i_clamp_max or the symmetric i_clamp) and allocates all states.*/
+    bool init(const ros::NodeHandle& n, const std::vector<std::string>& joint_names)
+    {
+        std::vector<std::string> gain_namespaces;
+        for(unsigned int i=0; i<joint_names.size(); i++)
+            gain_namespaces.push_back("pid_" + joint_names[i]);
+
+        return init(n, joint_names, gain_namespaces);
+    }
+
+    /**Same as above, but the gains of joint i are read from the sub-namespace gain_namespaces[i] of n.*/
+    bool init(const ros::NodeHandle& n, const std::vector<std::string>& joint_names, const std::vector<std::string>& gain_namespaces)
+    {
+        if(N != Eigen::Dynamic && joint_names.size() != (unsigned int)N)
+        {
+            ROS_ERROR("GroupPid::init(): got %d joints, but the group is compiled for %d joints!", (int)joint_names.size(), N);
+            return false;
+        }
+        if(gain_namespaces.size() != joint_names.size())
+        {
+            ROS_ERROR("GroupPid::init(): got %d gain namespaces for %d joints!", (int)gain_namespaces.size(), (int)joint_names.size());
+            return false;
+        }
+
+        n_joints_ = joint_names.size();
+        gains_.resize(n_joints_);
+        for(unsigned int i=0; i<n_joints_; i++)
+            if(!loadGains(ros::NodeHandle(n, gain_namespaces[i]), i))
+            {
+                ROS_ERROR("GroupPid::init(): could not load the gains for joint %s!", joint_names[i].c_str());
+                return false;
+            }
+
+        i_term_.setZero(n_joints_);
+        p_error_last_.setZero(n_joints_);
+        cmd_.setZero(n_joints_);
+        p_term_.setZero(n_joints_);
+        d_term_.setZero(n_joints_);
+
+        return true;
+    }
+
+    /**Clears the integrator and the error history.*/
+    void reset()
+    {
+        i_term_.setZero();
+        p_error_last_.setZero();
+        cmd_.setZero();
+        p_term_.setZero();
+        d_term_.setZero();
+    }
+
+    /**Clears the error history and starts the integrator from the given integral terms (clamped to the i_clamp bounds) for a bumpless start.*/
+    template <class Derived>
+    void reset(const Eigen::ArrayBase<Derived>& i_term)
+    {
+        reset();
+        i_term_ = i_term.max(gains_.i_min_).min(gains_.i_max_);
+        cmd_ = i_term_;
+    }
+
+    /**Computes the efforts for the given velocity errors and time step dt, the result stays valid until the next call. If dt is not positive, the previous command is returned.*/
+    template <class Derived>
+    const ArrayN& computeCommand(const Eigen::ArrayBase<Derived>& error, double dt)
+    {
+        if(!(dt > 0.0))
+            return cmd_;
+
+        p_term_ = gains_.p_ * error;
+        i_term_ = (i_term_ + gains_.i_ * error * dt).max(gains_.i_min_).min(gains_.i_max_);
+        d_term_ = gains_.d_ * (error - p_error_last_) / dt;
+        p_error_last_ = error;
+
+        cmd_ = p_term_ + i_term_ + d_term_;
+        return cmd_;
+    }
+
+    const Gains& getGains() const { return gains_; }
+    /**Real-time safe if the given gains have the size of the group. The integrator state is kept, it is clamped to the new bounds in the next computeCommand(...).*/
+    void setGains(const Gains& gains) { gains_ = gains; }
+    const ArrayN& getCommand() const { return cmd_; }
+    const ArrayN& getPTerm() const { return p_term_; }
+    const ArrayN& getITerm() const { return i_term_; }
+    const ArrayN& getDTerm() const { return d_term_; }
+    unsigned int size() const { return n_joints_; }
+
+private:
+
+    bool loadGains(const ros::NodeHandle& n, unsigned int i)
+    {
+        if(!n.getParam("p", gains_.p_(i)))
+        {
+            ROS_ERROR("No p gain specified for pid. Namespace: %s", n.getNamespace().c_str());
+            return false;
+        }
+        n.param("i", gains_.i_(i), 0.0);
+        n.param("d", gains_.d_(i), 0.0);
+
+        double i_clamp;
+        n.param("i_clamp", i_clamp, 0.0);
+        i_clamp = std::fabs(i_clamp);
+        n.param("i_clamp_min", gains_.i_min_(i), -i_clamp);
+        n.param("i_clamp_max", gains_.i_max_(i), i_clamp);
+
+        if(gains_.i_min_(i) > gains_.i_max_(i))
+        {
+            ROS_ERROR("i_clamp_min is larger than i_clamp_max. Namespace: %s", n.getNamespace().c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    unsigned int n_joints_;
+    Gains gains_;
+    ArrayN i_term_;
+    ArrayN p_error_last_;
+    ArrayN p_term_;
+    ArrayN d_term_;
+    ArrayN cmd_;
+};
+
+} //end namespace group_effort_controllers
+
+#endif
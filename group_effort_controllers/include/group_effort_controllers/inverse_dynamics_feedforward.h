@@ -0,0 +1,61 @@
+#ifndef INVERSE_DYNAMICS_FEEDFORWARD_H
+#define INVERSE_DYNAMICS_FEEDFORWARD_H
+
+#include <vector>
+#include <string>
+#include <Eigen/Core>
+#include <ros/node_handle.h>
+#include <boost/scoped_ptr.hpp>
+#include <kdl/chain.hpp>
+#include <kdl/jntarray.hpp>
+#include <kdl/chainidsolver_recursive_newton_euler.hpp>
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief Model-based feedforward efforts for a group of velocity controlled joints.
+   *
+   * A KDL chain between root_name and tip_name is built from the robot_description once in init(...). Each cycle,
+   * the recursive Newton-Euler solver computes the efforts for the current joint positions, the commanded
+   * velocities and the commanded accelerations (differentiated velocity commands, low-pass filtered), i.e.,
+   * tau = M(q) dq_cmd/dt + C(q, q_cmd) q_cmd + g(q). All joints of the chain have to be controlled by the group.
+   */
+class InverseDynamicsFeedforward
+{
+public:
+
+    InverseDynamicsFeedforward();
+
+    /**Reads the parameters from the "feedforward" sub-namespace of n and builds the solver. Also returns true if the feedforward is disabled.*/
+    bool init(ros::NodeHandle& n, const std::vector<std::string>& joint_names);
+
+    bool isEnabled() const { return enabled_; }
+
+    /**Starts the command differentiation from the given commands.*/
+    void reset(const Eigen::Ref<const Eigen::VectorXd>& commands);
+
+    /**Real-time safe. Returns the feedforward efforts ordered as the joints of the group, valid until the next call.*/
+    const Eigen::ArrayXd& compute(const Eigen::Ref<const Eigen::ArrayXd>& positions, const Eigen::Ref<const Eigen::VectorXd>& commands, double dt);
+
+    const Eigen::ArrayXd& getEfforts() const { return efforts_; }
+
+private:
+
+    bool enabled_;
+    double gain_;
+    double acceleration_cutoff_; ///< cutoff frequency of the command acceleration low-pass filter in Hz
+
+    KDL::Chain chain_;
+    boost::scoped_ptr<KDL::ChainIdSolver_RNE> solver_;
+    std::vector<unsigned int> chain_to_group_; ///< index of each chain joint in the group
+    KDL::JntArray q_, qd_, qdd_, tau_;
+    KDL::Wrenches f_ext_;
+
+    Eigen::VectorXd last_commands_;
+    Eigen::ArrayXd efforts_;
+};
+
+} //end namespace group_effort_controllers
+
+#endif
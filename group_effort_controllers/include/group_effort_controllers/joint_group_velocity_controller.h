@@ -8,47 +8,194 @@
 #include <boost/thread/condition.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/array.hpp>
 #include <hardware_interface/joint_command_interface.h>
 #include <controller_interface/controller.h>
-#include <control_msgs/JointControllerState.h>
+#include <group_effort_controllers/JointGroupControllerState.h>
+#include <group_effort_controllers/SetGroupGains.h>
 #include <std_msgs/Float64.h>
-#include <control_toolbox/pid.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <trajectory_msgs/JointTrajectory.h>
 #include <realtime_tools/realtime_publisher.h>
+#include <boost/atomic.hpp>
+#include <group_effort_controllers/realtime_triple_buffer.h>
+#include <group_effort_controllers/group_pid.h>
+#include <group_effort_controllers/cycle_monitor.h>
+#include <group_effort_controllers/controller_telemetry.h>
+#include <group_effort_controllers/flight_recorder.h>
+#include <group_effort_controllers/inverse_dynamics_feedforward.h>
+#include <group_effort_controllers/velocity_filter.h>
+#include <group_effort_controllers/gain_schedule.h>
+#include <group_effort_controllers/velocity_trajectory.h>
+#include <group_effort_controllers/disturbance_observer.h>
 
 namespace group_effort_controllers
 {
-#define PUBLISH_RATE 50 //The rate to publish
+#define PUBLISH_RATE 50 //Default rate of the state topic in Hz
+//--------------------------------------------------------
+/**
+   * \brief How the velocity commands reach the joints of a hardware interface: either through a local PID on the
+   * efforts, or passed through unchanged if the hardware tracks velocities itself.
+   */
+template <class HardwareInterface>
+struct VelocityCommandTraits;
+
+template <>
+struct VelocityCommandTraits<hardware_interface::EffortJointInterface> { enum { PASSTHROUGH = false }; };
+
+template <>
+struct VelocityCommandTraits<hardware_interface::VelocityJointInterface> { enum { PASSTHROUGH = true }; };
+//--------------------------------------------------------
+/**
+   * \brief Per-joint storage of a controller with N joints: a boost::array if N is known at compile time, so that the
+   * joints are laid out inline like the fixed-size Eigen states, else a std::vector sized in init(...).
+   */
+template <class T, int N>
+struct JointStorage
+{
+    typedef boost::array<T, N> type;
+    static void resize(type&, unsigned int) {} ///< the number of joints is checked against N in init(...)
+};
+
+template <class T>
+struct JointStorage<T, Eigen::Dynamic>
+{
+    typedef std::vector<T> type;
+    static void resize(type& storage, unsigned int n) { storage.resize(n); }
+};
 //--------------------------------------------------------
 /**
    * \brief velocity controller for a set of joints.
    *
+   * N is the number of joints if it is known at compile time, in which case all per-joint states are fixed-size
+   * Eigen arrays and the vectorized PID, filter and error computations are sized statically. With the default
+   * Eigen::Dynamic the number of joints is taken from the joints parameter.
+   *
+   * Several named groups (e.g., an arm and a gripper) can share one controller. Their joints are stored back to back, so
+   * all groups are computed in the same vectorized pass and published in one state message, while each group keeps its
+   * own gains, command topic and gain service.
+   *
+   * On an EffortJointInterface, the velocities are tracked with the group PID (plus the optional feedforward and
+   * disturbance compensation). On a VelocityJointInterface, the commands are written to the joints as they are - the
+   * effort path is compiled out and its parameters are ignored. Use the typedefs below.
    */
-class JointGroupVelocityController: public controller_interface::Controller<hardware_interface::EffortJointInterface>
+template <int N = Eigen::Dynamic, class HardwareInterface = hardware_interface::EffortJointInterface>
+class GenericJointGroupVelocityController: public controller_interface::Controller<HardwareInterface>
 {
 public:
 
-    JointGroupVelocityController();
-    ~JointGroupVelocityController();
+    typedef Eigen::Array<double, N, 1> ArrayN;
+    typedef Eigen::Matrix<double, N, 1> VectorN;
+    enum { PASSTHROUGH = VelocityCommandTraits<HardwareInterface>::PASSTHROUGH };
+
+    GenericJointGroupVelocityController();
+    ~GenericJointGroupVelocityController();
 
     std::vector< std::string > joint_names_;
-    std::vector< hardware_interface::JointHandle  > joints_;
+    typename JointStorage<hardware_interface::JointHandle, N>::type joints_; ///< handles in the order of joint_names_
 
-    Eigen::VectorXd commands_;
     unsigned int n_joints_;
 
-    bool init(hardware_interface::EffortJointInterface *hw, ros::NodeHandle &n);
+    bool init(HardwareInterface *hw, ros::NodeHandle &n);
     void starting(const ros::Time& time);
     void update(const ros::Time& time, const ros::Duration& period);
 
+    ///////////////////////
+    // COMMAND CALLBACKS //
+    ///////////////////////
+    //**The callbacks of the command topics, run in the spinner thread concurrently to update(). Like update(), they don't allocate.*/
+
+    //**Sets the velocity of joint i, the other joints keep their latest constant velocities.*/
+    void setCommandCB(const std_msgs::Float64ConstPtr& msg, unsigned int i);
+    //**Sets the velocities of the size joints starting at offset at once, the data has to be ordered as the joints of the group.*/
+    void setGroupCommandCB(const std_msgs::Float64MultiArrayConstPtr& msg, unsigned int offset, unsigned int size);
+    //**Sets time-stamped velocities for all joints, interpolated at the controller's clock. Positions, accelerations and efforts are ignored.*/
+    void setTrajectoryCommandCB(const trajectory_msgs::JointTrajectoryConstPtr& msg);
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
 private:
 
-    //    boost::mutex lock_;
-    ros::NodeHandle n_;
-    std::vector<control_toolbox::Pid> pids_;
+    //**A named subset of consecutive joints with its own command topic and gain service.*/
+    struct JointGroup
+    {
+        std::string name_;
+        unsigned int offset_; ///< index of the first joint of the group
+        unsigned int size_;
+        ros::Subscriber command_sub_;
+        ros::ServiceServer set_gains_srv_;
+    };
 
-    std::vector<boost::shared_ptr<ros::Subscriber> > command_sub_;
-    std::vector<boost::shared_ptr<realtime_tools::RealtimePublisher<control_msgs::JointControllerState> > > c_state_pub_;
+    ros::NodeHandle n_;
+    std::vector<JointGroup> groups_; ///< empty for a controller with a single, unnamed group
+
+    //**Commanded joint velocities (constant or timed points), written by the command callbacks and read by update() without blocking.*/
+    RealtimeTripleBuffer<VelocityTrajectory<N> > commands_buffer_;
+    //**Writer side copy of the latest constant commands - the per-joint callbacks only update single entries.*/
+    VectorN pending_commands_;
+    VectorN commands_; ///< velocities sampled from the command of the current cycle
+    double max_extrapolation_; ///< time in s for which timed commands are extrapolated after their last point
+    //**Serializes the command callbacks (there is only one writer allowed on commands_buffer_), never taken in update().*/
+    boost::mutex command_lock_;
+    std::vector<unsigned int> msg_index_; ///< index of each joint in the latest trajectory command, sized in init(...) so that the callback doesn't allocate
+    //**Set by starting() to make the writer discard commands received before the controller was started.*/
+    boost::atomic<bool> reset_commands_;
+
+    GroupPid<N> pid_;
+    //**Complete gain sets built by setGainsCB(...), swapped into pid_ at the start of a cycle so that all joints change gains at once.*/
+    RealtimeTripleBuffer<typename GroupPid<N>::Gains> gains_buffer_;
+    typename GroupPid<N>::Gains pending_gains_; ///< writer side copy of the latest gains
+    boost::mutex gains_lock_; ///< serializes the gain service calls, never taken in update()
+    ros::ServiceServer set_gains_srv_;
+
+    //**Optional configuration dependent scaling of the p, i and d gains of the latest gain set.*/
+    GainSchedule<N> gain_schedule_;
+    typename GroupPid<N>::Gains scheduled_gains_; ///< gains after scaling, set in pid_ every cycle if the schedule is enabled
+    ArrayN measured_velocities_; ///< raw joint velocities of the current cycle
+    ArrayN velocities_; ///< estimated joint velocities of the current cycle, used as process values
+    ArrayN errors_; ///< velocity errors of the current cycle
+    ArrayN last_velocities_; ///< estimated joint velocities of the previous cycle
+    ArrayN positions_; ///< measured joint positions of the current cycle, only read if the feedforward, the velocity filter or the gain schedule need them
+    bool read_positions_;
+
+    //**Optional filter/observer on the measured velocities ahead of the PID.*/
+    VelocityFilter<N> velocity_filter_;
+    ArrayN commanded_efforts_; ///< PID, feedforward and disturbance compensation efforts sent to the joints, the commanded velocities in the passthrough
+
+    //**Optional inverse dynamics feedforward added to the PID efforts.*/
+    InverseDynamicsFeedforward feedforward_;
+
+    //**Optional disturbance observer, its estimate is subtracted from the PID and feedforward efforts.*/
+    DisturbanceObserver<N> disturbance_observer_;
+
+    ros::Subscriber group_command_sub_;
+    ros::Subscriber trajectory_command_sub_;
+    std::vector<boost::shared_ptr<ros::Subscriber> > command_sub_; ///< legacy per-joint command subscribers
+    boost::shared_ptr<realtime_tools::RealtimePublisher<JointGroupControllerState> > c_state_pub_; ///< publishes the state of all joints in one message
     ros::Time last_publish_time_;
+    double publish_rate_; ///< rate of the state topic in Hz, 0 disables it (and c_state_pub_ isn't created)
+    ros::Duration publish_period_; ///< 1/publish_rate_, computed once in init(...)
+
+    //**Execution time and period statistics of update(), published by publishStatisticsCB(...) outside of the real-time loop.*/
+    CycleMonitor cycle_monitor_;
+    ros::Publisher statistics_pub_;
+    ros::WallTimer statistics_timer_;
+    CycleStatistics statistics_;
+
+    //**Bumpless start: the integrator is seeded with the efforts applied before the controller was started, the command ramps from the measured velocities to zero.*/
+    enum IntegratorSeed { SEED_NONE, SEED_COMMAND, SEED_EFFORT };
+    IntegratorSeed integrator_seed_;
+    double command_ramp_; ///< duration of the ramp in s, 0 starts with zero velocities
+    ArrayN seed_efforts_; ///< efforts applied to the joints before the controller was started
+
+    //**Optional lossless recording of every cycle, in addition to the decimated state publisher.*/
+    ControllerTelemetry telemetry_;
+
+    //**Optional ring of the last cycles in shared memory which survives a crash of the process, dumped to a file outside of the real-time loop.*/
+    FlightRecorder flight_recorder_;
+    ros::WallTimer flight_recorder_timer_; ///< periodic dumps, declared after flight_recorder_ so that it is stopped first
+    ArrayN efforts_; ///< measured joint efforts of the current cycle, only read if the flight recorder is active
+    ArrayN zero_terms_; ///< recorded as P, I and D terms in the passthrough
 
     //**Helper function to read joint limits from the parameter server and generate the corresponding tasks.*/
    // bool jointLimitsParser(ros::NodeHandle &n);
@@ -57,10 +204,20 @@ private:
     // CALLBACKS //
     ///////////////
 
- void setCommandCB(const std_msgs::Float64ConstPtr& msg, unsigned int i);
+    void publishStatisticsCB(const ros::WallTimerEvent& event);
+    void dumpFlightRecorderCB(const ros::WallTimerEvent& event);
+    //**Replaces the gains of the size joints starting at offset.*/
+    bool setGainsCB(SetGroupGains::Request& req, SetGroupGains::Response& res, unsigned int offset, unsigned int size);
 
 };
 
+//**Controller for any number of joints, sized at runtime.*/
+typedef GenericJointGroupVelocityController<Eigen::Dynamic> JointGroupVelocityController;
+//**Controllers for 7 and 8 joint groups (e.g., a 7-DOF arm, with the gripper).*/
+typedef GenericJointGroupVelocityController<7> JointGroupVelocityController7;
+typedef GenericJointGroupVelocityController<8> JointGroupVelocityController8;
+//**Passes the velocities on to hardware which tracks them itself, for any number of joints.*/
+typedef GenericJointGroupVelocityController<Eigen::Dynamic, hardware_interface::VelocityJointInterface> JointGroupVelocityPassthroughController;
 
 } //end namespace group_effort_controllers
 
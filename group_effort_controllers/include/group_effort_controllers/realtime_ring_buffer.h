@@ -0,0 +1,99 @@
+#ifndef REALTIME_RING_BUFFER_H
+#define REALTIME_RING_BUFFER_H
+
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief Lock-free single-producer/single-consumer ring buffer of preallocated records.
+   *
+   * All slots are copies of a prototype given to initialize(...), so records holding dynamically sized
+   * members (e.g., Eigen::VectorXd) can be filled in place without allocating. The producer fills the
+   * slot returned by acquire() and hands it over with commit(); if the consumer falls behind, acquire()
+   * returns NULL and the record is counted as dropped.
+   */
+template <class T>
+class RealtimeRingBuffer : boost::noncopyable
+{
+public:
+
+    RealtimeRingBuffer() : head_(0), tail_(0), dropped_(0) {}
+
+    /**Allocates capacity slots initialized with prototype. Not thread safe - call before producer and consumer start.*/
+    void initialize(unsigned int capacity, const T& prototype)
+    {
+        slots_.assign(capacity + 1, prototype); //one slot is always kept free to tell a full from an empty buffer
+        head_.store(0);
+        tail_.store(0);
+        dropped_.store(0);
+    }
+
+    unsigned int capacity() const { return slots_.empty() ? 0 : slots_.size() - 1; }
+
+    /////////////////////
+    // PRODUCER SIDE  //
+    ////////////////////
+
+    /**Returns the next free slot or NULL if the buffer is full.*/
+    T* acquire()
+    {
+        if(slots_.empty())
+            return NULL;
+
+        unsigned int head = head_.load(boost::memory_order_relaxed);
+        if(next(head) == tail_.load(boost::memory_order_acquire))
+        {
+            dropped_.store(dropped_.load(boost::memory_order_relaxed) + 1, boost::memory_order_relaxed);
+            return NULL;
+        }
+
+        return &slots_[head];
+    }
+
+    /**Makes the slot obtained from the last successful acquire() visible to the consumer.*/
+    void commit()
+    {
+        head_.store(next(head_.load(boost::memory_order_relaxed)), boost::memory_order_release);
+    }
+
+    /////////////////////
+    // CONSUMER SIDE  //
+    ////////////////////
+
+    /**Returns the oldest record or NULL if the buffer is empty. The record stays valid until pop() is called.*/
+    const T* front() const
+    {
+        unsigned int tail = tail_.load(boost::memory_order_relaxed);
+        if(tail == head_.load(boost::memory_order_acquire))
+            return NULL;
+
+        return &slots_[tail];
+    }
+
+    /**Releases the record returned by front().*/
+    void pop()
+    {
+        tail_.store(next(tail_.load(boost::memory_order_relaxed)), boost::memory_order_release);
+    }
+
+    /**Number of records the producer couldn't store because the buffer was full.*/
+    boost::uint64_t dropped() const { return dropped_.load(boost::memory_order_relaxed); }
+
+private:
+
+    unsigned int next(unsigned int i) const { return (i + 1 == slots_.size()) ? 0 : i + 1; }
+
+    std::vector<T> slots_;
+    boost::atomic<unsigned int> head_; ///< next slot to be written, owned by the producer
+    boost::atomic<unsigned int> tail_; ///< next slot to be read, owned by the consumer
+    boost::atomic<boost::uint64_t> dropped_;
+};
+
+} //end namespace group_effort_controllers
+
+#endif
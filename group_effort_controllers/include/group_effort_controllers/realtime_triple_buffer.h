@@ -0,0 +1,88 @@
+#ifndef REALTIME_TRIPLE_BUFFER_H
+#define REALTIME_TRIPLE_BUFFER_H
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief Wait-free single-writer/single-reader triple buffer.
+   *
+   * The writer fills the back slot and swaps it with the middle slot, the reader swaps the middle slot
+   * into the front slot if the writer marked it as fresh. Neither side ever blocks, and the reader always
+   * sees a complete value. Slots are meant to be sized once via initialize(...) outside of the real-time
+   * loop so that subsequent copies do not allocate.
+   */
+template <class T>
+class RealtimeTripleBuffer : boost::noncopyable
+{
+public:
+
+    RealtimeTripleBuffer() : state_(MIDDLE_INIT), back_(BACK_INIT), front_(FRONT_INIT) {}
+
+    /**Fills all slots with the given value. Not thread safe - call before reader and writer start.*/
+    void initialize(const T& value)
+    {
+        for(unsigned int i=0; i<3; i++)
+            buffer_[i] = value;
+
+        state_.store(MIDDLE_INIT, boost::memory_order_relaxed);
+        back_ = BACK_INIT;
+        front_ = FRONT_INIT;
+    }
+
+    ///////////////////
+    // WRITER SIDE  //
+    //////////////////
+
+    /**Slot which can be freely written by the writer, call publish() when done.*/
+    T& back() { return buffer_[back_]; }
+
+    /**Hands the back slot to the reader and takes over the previous middle slot.*/
+    void publish()
+    {
+        unsigned int prev = state_.exchange(back_ | FRESH_BIT, boost::memory_order_acq_rel);
+        back_ = prev & INDEX_MASK;
+    }
+
+    /**Convenience function combining back() and publish().*/
+    void write(const T& value)
+    {
+        back() = value;
+        publish();
+    }
+
+    ///////////////////
+    // READER SIDE  //
+    //////////////////
+
+    /**Swaps in the latest published value if there is one. Returns true if the front slot was updated.*/
+    bool update()
+    {
+        if(!(state_.load(boost::memory_order_relaxed) & FRESH_BIT))
+            return false;
+
+        unsigned int prev = state_.exchange(front_, boost::memory_order_acq_rel);
+        front_ = prev & INDEX_MASK;
+        return true;
+    }
+
+    /**The latest value received by the reader.*/
+    const T& front() const { return buffer_[front_]; }
+    T& front() { return buffer_[front_]; }
+
+private:
+
+    enum { FRONT_INIT = 0, MIDDLE_INIT = 1, BACK_INIT = 2, INDEX_MASK = 3, FRESH_BIT = 4 };
+
+    T buffer_[3];
+    boost::atomic<unsigned int> state_; ///< index of the middle slot plus FRESH_BIT if it hasn't been read yet
+    unsigned int back_; ///< owned by the writer
+    unsigned int front_; ///< owned by the reader
+};
+
+} //end namespace group_effort_controllers
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef STEP_RESPONSE_H
+#define STEP_RESPONSE_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace group_effort_controllers
+{
+#define STEP_THRESHOLD 0.1 //minimum set point jump relative to the set point range of the joint to count as step
+#define RISE_LOW 0.1
+#define RISE_HIGH 0.9
+#define SETTLING_BAND 0.02
+//---------------------------------------------------------------------
+/**Step response of one joint, times in s relative to the step, overshoot relative to the step size. Negative times mean the response didn't get there before the next step.*/
+struct StepResponse
+{
+    double rise_time_;
+    double overshoot_;
+    double settling_time_;
+};
+//---------------------------------------------------------------------
+/**Finds the set point steps in the given signals and evaluates the response of the velocity up to the next step.*/
+inline std::vector<StepResponse> stepResponses(const std::vector<double>& t, const std::vector<double>& set_point, const std::vector<double>& velocity)
+{
+    std::vector<StepResponse> responses;
+    if(t.size() < 2)
+        return responses;
+
+    double range = *std::max_element(set_point.begin(), set_point.end()) - *std::min_element(set_point.begin(), set_point.end());
+    if(range <= 0.0)
+        return responses;
+
+    std::vector<unsigned int> steps;
+    for(unsigned int k=1; k<t.size(); k++)
+        if(std::fabs(set_point[k] - set_point[k-1]) > STEP_THRESHOLD * range)
+            steps.push_back(k);
+    steps.push_back(t.size());
+
+    for(unsigned int s=0; s+1<steps.size(); s++)
+    {
+        unsigned int k0 = steps[s], k1 = steps[s+1];
+        double from = set_point[k0-1], to = set_point[k0], size = to - from;
+        double t_low = -1.0, t_high = -1.0, t_settled = -1.0, overshoot = 0.0;
+
+        for(unsigned int k=k0; k<k1; k++)
+        {
+            double progress = (velocity[k] - from) / size; //0 before, 1 at the new set point
+            if(t_low < 0.0 && progress >= RISE_LOW)
+                t_low = t[k];
+            if(t_high < 0.0 && progress >= RISE_HIGH)
+                t_high = t[k];
+            overshoot = std::max(overshoot, progress - 1.0);
+            if(std::fabs(progress - 1.0) > SETTLING_BAND)
+                t_settled = -1.0;
+            else if(t_settled < 0.0)
+                t_settled = t[k];
+        }
+
+        StepResponse r;
+        r.rise_time_ = (t_low >= 0.0 && t_high >= 0.0) ? t_high - t_low : -1.0;
+        r.overshoot_ = overshoot;
+        r.settling_time_ = (t_settled >= 0.0) ? t_settled - t[k0] : -1.0;
+        responses.push_back(r);
+    }
+
+    return responses;
+}
+//---------------------------------------------------------------------
+/**Root mean square of set_point - velocity over all samples.*/
+inline double rmsError(const std::vector<double>& set_point, const std::vector<double>& velocity)
+{
+    if(set_point.empty())
+        return 0.0;
+
+    double sq_sum = 0.0;
+    for(unsigned int k=0; k<set_point.size(); k++)
+        sq_sum += (set_point[k] - velocity[k]) * (set_point[k] - velocity[k]);
+
+    return std::sqrt(sq_sum / set_point.size());
+}
+
+} //end namespace group_effort_controllers
+
+#endif
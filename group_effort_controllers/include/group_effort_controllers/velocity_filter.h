@@ -0,0 +1,153 @@
+#ifndef VELOCITY_FILTER_H
+#define VELOCITY_FILTER_H
+
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Core>
+#include <ros/node_handle.h>
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief Velocity estimator for a group of joints.
+   *
+   * Filters the measured velocities of all joints in one vectorized pass. Available types are
+   * "none", "low_pass" (first order), "butterworth" (second order, coefficients are recomputed when the
+   * time step changes) and "alpha_beta" (observer driven by the measured positions only). N is the number
+   * of joints or Eigen::Dynamic, all states are allocated in init(...).
+   */
+template <int N = Eigen::Dynamic>
+class VelocityFilter
+{
+public:
+
+    typedef Eigen::Array<double, N, 1> ArrayN;
+
+    enum Type { NONE, LOW_PASS, BUTTERWORTH, ALPHA_BETA };
+
+    VelocityFilter() : type_(NONE), cutoff_(50.0), alpha_(0.5), beta_(0.1), dt_(0.0), b0_(0.0), a1_(0.0), a2_(0.0) {}
+
+    /**Reads the parameters from the "velocity_filter" sub-namespace of n, no filtering is done if the type is not given.*/
+    bool init(const ros::NodeHandle& n, unsigned int n_joints)
+    {
+        ros::NodeHandle f_n(n, "velocity_filter");
+        std::string type;
+        f_n.param<std::string>("type", type, "none");
+        if(type == "none")
+            type_ = NONE;
+        else if(type == "low_pass")
+            type_ = LOW_PASS;
+        else if(type == "butterworth")
+            type_ = BUTTERWORTH;
+        else if(type == "alpha_beta")
+            type_ = ALPHA_BETA;
+        else
+        {
+            ROS_ERROR("Unknown velocity filter type '%s' (namespace: %s).", type.c_str(), f_n.getNamespace().c_str());
+            return false;
+        }
+
+        f_n.param("cutoff", cutoff_, 50.0);
+        f_n.param("alpha", alpha_, 0.5);
+        f_n.param("beta", beta_, 0.1);
+        if(cutoff_ <= 0.0 || alpha_ <= 0.0 || alpha_ > 1.0 || beta_ <= 0.0 || beta_ >= 4.0 - 2.0 * alpha_)
+        {
+            ROS_ERROR("Invalid velocity filter parameters - need cutoff > 0, 0 < alpha <= 1 and 0 < beta < 4 - 2 alpha (namespace: %s).", f_n.getNamespace().c_str());
+            return false;
+        }
+
+        x1_.setZero(n_joints); x2_.setZero(n_joints);
+        y1_.setZero(n_joints); y2_.setZero(n_joints);
+        position_.setZero(n_joints);
+        velocity_.setZero(n_joints);
+        residual_.setZero(n_joints);
+
+        return true;
+    }
+
+    bool isEnabled() const { return type_ != NONE; }
+    /**True if update(...) needs the measured positions.*/
+    bool needsPositions() const { return type_ == ALPHA_BETA; }
+
+    /**Initializes the filter states with the given measurements, so that the estimate starts without transient.*/
+    void reset(const ArrayN& positions, const ArrayN& velocities)
+    {
+        x1_ = velocities; x2_ = velocities;
+        y1_ = velocities; y2_ = velocities;
+        position_ = positions;
+        velocity_ = velocities;
+    }
+
+    /**Real-time safe. Returns the estimated velocities, valid until the next call.*/
+    const ArrayN& update(const ArrayN& positions, const ArrayN& velocities, double dt)
+    {
+        if(!(dt > 0.0))
+            return velocity_;
+
+        switch(type_)
+        {
+        case NONE:
+            velocity_ = velocities;
+            break;
+
+        case LOW_PASS:
+            if(dt != dt_)
+            {
+                dt_ = dt;
+                a1_ = 1.0 - std::exp(-2.0 * M_PI * cutoff_ * dt);
+            }
+            velocity_ += a1_ * (velocities - velocity_);
+            break;
+
+        case BUTTERWORTH:
+            if(dt != dt_)
+                computeButterworthCoefficients(dt);
+
+            velocity_ = b0_ * (velocities + 2.0 * x1_ + x2_) - a1_ * y1_ - a2_ * y2_;
+            x2_ = x1_; x1_ = velocities;
+            y2_ = y1_; y1_ = velocity_;
+            break;
+
+        case ALPHA_BETA:
+            position_ += velocity_ * dt;
+            residual_ = positions - position_;
+            position_ += alpha_ * residual_;
+            velocity_ += (beta_ / dt) * residual_;
+            break;
+        }
+
+        return velocity_;
+    }
+
+    const ArrayN& getVelocities() const { return velocity_; }
+
+private:
+
+    /**Second order Butterworth low-pass, bilinear transform with frequency prewarping.*/
+    void computeButterworthCoefficients(double dt)
+    {
+        dt_ = dt;
+        double k = std::tan(M_PI * std::min(cutoff_ * dt, 0.49)); //stay below the Nyquist frequency
+        double norm = 1.0 / (1.0 + M_SQRT2 * k + k * k);
+        b0_ = k * k * norm;
+        a1_ = 2.0 * (k * k - 1.0) * norm;
+        a2_ = (1.0 - M_SQRT2 * k + k * k) * norm;
+    }
+
+    Type type_;
+    double cutoff_; ///< cutoff frequency in Hz for the low-pass and Butterworth filters
+    double alpha_, beta_; ///< alpha-beta observer gains
+    double dt_; ///< time step the coefficients were computed for
+    double b0_, a1_, a2_;
+
+    ArrayN x1_, x2_, y1_, y2_; ///< Butterworth input and output history
+    ArrayN position_; ///< alpha-beta position estimate
+    ArrayN velocity_; ///< velocity estimate
+    ArrayN residual_;
+};
+
+} //end namespace group_effort_controllers
+
+#endif
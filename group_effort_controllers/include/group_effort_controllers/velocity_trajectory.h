@@ -0,0 +1,108 @@
+#ifndef VELOCITY_TRAJECTORY_H
+#define VELOCITY_TRAJECTORY_H
+
+#include <Eigen/Core>
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief Velocity command for a group of joints, either constant or a short sequence of time-stamped points.
+   *
+   * Constant commands (e.g., from the Float64MultiArray command topic) are held until the next command. Timed points
+   * are interpolated linearly at the controller's own clock, so the command changes every cycle instead of in steps
+   * at the (lower and jittery) rate of the sender. After the last point, the last segment is extrapolated linearly for
+   * at most max_extrapolation seconds, after that the command is considered stale and all velocities are zero.
+   * Storage for max_points points is allocated once in resize(...).
+   */
+template <int N = Eigen::Dynamic>
+class VelocityTrajectory
+{
+public:
+
+    typedef Eigen::Matrix<double, N, 1> VectorN;
+    typedef Eigen::Matrix<double, N, Eigen::Dynamic> PointsN;
+
+    VelocityTrajectory() : n_points_(0), constant_(true), segment_(0) {}
+
+    void resize(unsigned int n_joints, unsigned int max_points)
+    {
+        times_.setZero(max_points);
+        points_.setZero(n_joints, max_points);
+        n_points_ = 1;
+        constant_ = true;
+        segment_ = 0;
+    }
+
+    unsigned int maxPoints() const { return times_.size(); }
+
+    /**Holds the given velocities until the next command.*/
+    template <class Derived>
+    void setConstant(const Eigen::MatrixBase<Derived>& velocities)
+    {
+        points_.col(0) = velocities;
+        n_points_ = 1;
+        constant_ = true;
+        segment_ = 0;
+    }
+
+    /**Fill times() and points() with n_points points (strictly increasing times in s, same clock as sample(...)) first.*/
+    void setTimed(unsigned int n_points)
+    {
+        n_points_ = n_points;
+        constant_ = false;
+        segment_ = 0;
+    }
+
+    Eigen::VectorXd& times() { return times_; }
+    PointsN& points() { return points_; }
+
+    /**Real-time safe. Writes the velocities at time t to velocities, returns false if the command is stale.*/
+    template <class Derived>
+    bool sample(double t, double max_extrapolation, Eigen::MatrixBase<Derived>& velocities)
+    {
+        if(constant_)
+        {
+            velocities = points_.col(0);
+            return true;
+        }
+
+        //before the first point
+        if(n_points_ == 1 || t <= times_(0))
+        {
+            if(t > times_(n_points_ - 1) + max_extrapolation)
+            {
+                velocities.setZero();
+                return false;
+            }
+            velocities = points_.col(t <= times_(0) ? 0 : n_points_ - 1);
+            return true;
+        }
+
+        //the segment only moves forward, as the controller clock does
+        while(segment_ + 2 < n_points_ && t >= times_(segment_ + 1))
+            segment_++;
+
+        //t is only after the end of the segment if it is the last one
+        unsigned int k = segment_;
+        if(t > times_(k + 1) + max_extrapolation)
+        {
+            velocities.setZero();
+            return false;
+        }
+        velocities = points_.col(k) + (points_.col(k + 1) - points_.col(k)) * ((t - times_(k)) / (times_(k + 1) - times_(k)));
+        return true;
+    }
+
+private:
+
+    Eigen::VectorXd times_;
+    PointsN points_; ///< one column per point
+    unsigned int n_points_;
+    bool constant_;
+    unsigned int segment_; ///< first point of the segment used in the previous sample(...)
+};
+
+} //end namespace group_effort_controllers
+
+#endif
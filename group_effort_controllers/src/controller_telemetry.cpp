@@ -0,0 +1,175 @@
+#include <group_effort_controllers/controller_telemetry.h>
+#include <boost/cstdint.hpp>
+
+namespace group_effort_controllers
+{
+  //-----------------------------------------------------------------------
+  ControllerTelemetry::ControllerTelemetry() : output_(OUTPUT_NONE), n_joints_(0), drain_rate_(100.0), max_batch_size_(100) {}
+  //-----------------------------------------------------------------------
+  ControllerTelemetry::~ControllerTelemetry()
+  {
+    stop();
+  }
+  //-----------------------------------------------------------------------
+  bool ControllerTelemetry::init(ros::NodeHandle& n, const std::vector<std::string>& joint_names)
+  {
+    ros::NodeHandle t_n(n, "telemetry");
+    std::string output;
+    t_n.param<std::string>("output", output, "");
+    if(output.empty())
+      {
+	output_ = OUTPUT_NONE;
+	return true;
+      }
+    else if(output == "topic")
+      output_ = OUTPUT_TOPIC;
+    else if(output == "file")
+      output_ = OUTPUT_FILE;
+    else
+      {
+	ROS_ERROR("Unknown telemetry output '%s' - has to be 'topic' or 'file' (namespace: %s).", output.c_str(), t_n.getNamespace().c_str());
+	return false;
+      }
+
+    int buffer_size;
+    t_n.param("buffer_size", buffer_size, 1000);
+    t_n.param("drain_rate", drain_rate_, 100.0);
+    if(buffer_size < 1 || drain_rate_ <= 0.0)
+      {
+	ROS_ERROR("Invalid telemetry parameters (namespace: %s).", t_n.getNamespace().c_str());
+	return false;
+      }
+
+    n_joints_ = joint_names.size();
+    TelemetryRecord prototype;
+    prototype.time_step_ = 0.0;
+    prototype.set_point_.setZero(n_joints_);
+    prototype.process_value_.setZero(n_joints_);
+    prototype.error_.setZero(n_joints_);
+    prototype.command_.setZero(n_joints_);
+    buffer_.initialize(buffer_size, prototype);
+
+    if(output_ == OUTPUT_TOPIC)
+      {
+	int max_batch_size;
+	t_n.param("max_batch_size", max_batch_size, 100);
+	max_batch_size_ = (max_batch_size > 0) ? max_batch_size : 1;
+	msg_.joint_names = joint_names;
+	telemetry_pub_ = n.advertise<JointGroupTelemetry>("telemetry", 100);
+      }
+    else
+      {
+	std::string file_name;
+	if(!t_n.getParam("file_name", file_name))
+	  {
+	    ROS_ERROR("No telemetry file_name given (namespace: %s).", t_n.getNamespace().c_str());
+	    return false;
+	  }
+	file_.open(file_name.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!file_.is_open())
+	  {
+	    ROS_ERROR("Could not open telemetry file %s.", file_name.c_str());
+	    return false;
+	  }
+
+	boost::uint32_t version = 1, n_joints = n_joints_;
+	file_.write("GECT", 4);
+	file_.write((const char*)&version, sizeof(version));
+	file_.write((const char*)&n_joints, sizeof(n_joints));
+	for(unsigned int i=0; i<n_joints_; i++)
+	  {
+	    boost::uint32_t length = joint_names[i].size();
+	    file_.write((const char*)&length, sizeof(length));
+	    file_.write(joint_names[i].c_str(), length);
+	  }
+	file_record_.resize(2 + 4 * n_joints_);
+      }
+
+    drain_thread_ = boost::thread(&ControllerTelemetry::drain, this);
+    return true;
+  }
+  //-----------------------------------------------------------------------
+  void ControllerTelemetry::stop()
+  {
+    if(!drain_thread_.joinable())
+      return;
+
+    drain_thread_.interrupt();
+    drain_thread_.join();
+    flush();
+    if(file_.is_open())
+      file_.close();
+  }
+  //-----------------------------------------------------------------------
+  void ControllerTelemetry::drain()
+  {
+    boost::posix_time::microseconds sleep_time((boost::int64_t)(1e6 / drain_rate_));
+    try
+      {
+	while(true)
+	  {
+	    flush();
+	    boost::this_thread::sleep(sleep_time);
+	  }
+      }
+    catch(const boost::thread_interrupted&) {}
+  }
+  //-----------------------------------------------------------------------
+  void ControllerTelemetry::flush()
+  {
+    if(output_ == OUTPUT_TOPIC)
+      publishRecords();
+    else if(output_ == OUTPUT_FILE)
+      writeRecords();
+  }
+  //-----------------------------------------------------------------------
+  void ControllerTelemetry::publishRecords()
+  {
+    const TelemetryRecord* rec = buffer_.front();
+    while(rec)
+      {
+	msg_.stamps.clear();
+	msg_.time_steps.clear();
+	msg_.set_point.clear();
+	msg_.process_value.clear();
+	msg_.error.clear();
+	msg_.command.clear();
+
+	for(unsigned int n=0; rec && n<max_batch_size_; n++)
+	  {
+	    msg_.stamps.push_back(rec->stamp_);
+	    msg_.time_steps.push_back(rec->time_step_);
+	    msg_.set_point.insert(msg_.set_point.end(), rec->set_point_.data(), rec->set_point_.data() + n_joints_);
+	    msg_.process_value.insert(msg_.process_value.end(), rec->process_value_.data(), rec->process_value_.data() + n_joints_);
+	    msg_.error.insert(msg_.error.end(), rec->error_.data(), rec->error_.data() + n_joints_);
+	    msg_.command.insert(msg_.command.end(), rec->command_.data(), rec->command_.data() + n_joints_);
+
+	    buffer_.pop();
+	    rec = buffer_.front();
+	  }
+
+	msg_.header.stamp = msg_.stamps.back();
+	msg_.dropped = buffer_.dropped();
+	telemetry_pub_.publish(msg_);
+      }
+  }
+  //-----------------------------------------------------------------------
+  void ControllerTelemetry::writeRecords()
+  {
+    const TelemetryRecord* rec;
+    while((rec = buffer_.front()))
+      {
+	file_record_[0] = rec->stamp_.toSec();
+	file_record_[1] = rec->time_step_;
+	Eigen::Map<Eigen::ArrayXd>(&file_record_[2], n_joints_) = rec->set_point_;
+	Eigen::Map<Eigen::ArrayXd>(&file_record_[2 + n_joints_], n_joints_) = rec->process_value_;
+	Eigen::Map<Eigen::ArrayXd>(&file_record_[2 + 2 * n_joints_], n_joints_) = rec->error_;
+	Eigen::Map<Eigen::ArrayXd>(&file_record_[2 + 3 * n_joints_], n_joints_) = rec->command_;
+	buffer_.pop();
+
+	file_.write((const char*)&file_record_[0], file_record_.size() * sizeof(double));
+      }
+    file_.flush();
+  }
+  //-----------------------------------------------------------------------
+} //end namespace group_effort_controllers
@@ -0,0 +1,114 @@
+#include <group_effort_controllers/cycle_monitor.h>
+#include <cmath>
+
+namespace group_effort_controllers
+{
+  //-----------------------------------------------------------------------
+  CycleMonitor::CycleMonitor() : nominal_period_(0.001), budget_(0.001), bin_width_(1e-5), n_bins_(0), cycles_(0), overruns_(0), missed_cycles_(0), exec_time_sum_ns_(0), exec_time_max_ns_(0), jitter_max_ns_(0) {}
+  //-----------------------------------------------------------------------
+  void CycleMonitor::init(double nominal_period, double budget, double bin_width, unsigned int n_bins)
+  {
+    nominal_period_ = nominal_period;
+    budget_ = budget;
+    bin_width_ = bin_width;
+    n_bins_ = n_bins;
+
+    exec_time_histogram_.reset(new Counter[n_bins_]);
+    jitter_histogram_.reset(new Counter[n_bins_]);
+    for(unsigned int i=0; i<n_bins_; i++)
+      {
+	exec_time_histogram_[i].store(0);
+	jitter_histogram_[i].store(0);
+      }
+
+    cycles_.store(0);
+    overruns_.store(0);
+    missed_cycles_.store(0);
+    exec_time_sum_ns_.store(0);
+    exec_time_max_ns_.store(0);
+    jitter_max_ns_.store(0);
+  }
+  //-----------------------------------------------------------------------
+  unsigned int CycleMonitor::bin(double value) const
+  {
+    double b = std::floor(value / bin_width_);
+    if(!(b < n_bins_ - 1)) //also catches NaN
+      return n_bins_ - 1;
+
+    return (b > 0.0) ? (unsigned int)b : 0;
+  }
+  //-----------------------------------------------------------------------
+  void CycleMonitor::record(double exec_time, double period)
+  {
+    if(n_bins_ == 0)
+      return;
+
+    double jitter = std::fabs(period - nominal_period_);
+
+    increment(exec_time_histogram_[bin(exec_time)]);
+    increment(jitter_histogram_[bin(jitter)]);
+    increment(cycles_);
+
+    if(exec_time > budget_)
+      increment(overruns_);
+    if(period >= 2.0 * nominal_period_)
+      increment(missed_cycles_);
+
+    boost::uint64_t exec_time_ns = (boost::uint64_t)(exec_time * 1e9);
+    boost::uint64_t jitter_ns = (boost::uint64_t)(jitter * 1e9);
+    exec_time_sum_ns_.store(exec_time_sum_ns_.load(boost::memory_order_relaxed) + exec_time_ns, boost::memory_order_relaxed);
+    if(exec_time_ns > exec_time_max_ns_.load(boost::memory_order_relaxed))
+      exec_time_max_ns_.store(exec_time_ns, boost::memory_order_relaxed);
+    if(jitter_ns > jitter_max_ns_.load(boost::memory_order_relaxed))
+      jitter_max_ns_.store(jitter_ns, boost::memory_order_relaxed);
+  }
+  //-----------------------------------------------------------------------
+  double CycleMonitor::percentile(const boost::scoped_array<Counter>& histogram, boost::uint64_t count, double p) const
+  {
+    if(count == 0)
+      return 0.0;
+
+    //upper edge of the first bin at which the cumulated count reaches the percentile
+    boost::uint64_t threshold = (boost::uint64_t)std::ceil(p * count);
+    boost::uint64_t sum = 0;
+    for(unsigned int i=0; i<n_bins_; i++)
+      {
+	sum += histogram[i].load(boost::memory_order_relaxed);
+	if(sum >= threshold)
+	  return (i + 1) * bin_width_;
+      }
+
+    return n_bins_ * bin_width_;
+  }
+  //-----------------------------------------------------------------------
+  void CycleMonitor::getStatistics(CycleStatistics& stats) const
+  {
+    stats.nominal_period = nominal_period_;
+    stats.budget = budget_;
+    stats.bin_width = bin_width_;
+    stats.exec_time_histogram.resize(n_bins_);
+    stats.jitter_histogram.resize(n_bins_);
+
+    boost::uint64_t n_exec = 0, n_jitter = 0;
+    for(unsigned int i=0; i<n_bins_; i++)
+      {
+	stats.exec_time_histogram[i] = exec_time_histogram_[i].load(boost::memory_order_relaxed);
+	stats.jitter_histogram[i] = jitter_histogram_[i].load(boost::memory_order_relaxed);
+	n_exec += stats.exec_time_histogram[i];
+	n_jitter += stats.jitter_histogram[i];
+      }
+
+    stats.cycles = cycles_.load(boost::memory_order_relaxed);
+    stats.overruns = overruns_.load(boost::memory_order_relaxed);
+    stats.missed_cycles = missed_cycles_.load(boost::memory_order_relaxed);
+    stats.exec_time_max = 1e-9 * exec_time_max_ns_.load(boost::memory_order_relaxed);
+    stats.jitter_max = 1e-9 * jitter_max_ns_.load(boost::memory_order_relaxed);
+    stats.exec_time_mean = (stats.cycles > 0) ? 1e-9 * exec_time_sum_ns_.load(boost::memory_order_relaxed) / stats.cycles : 0.0;
+
+    stats.exec_time_p50 = percentile(exec_time_histogram_, n_exec, 0.5);
+    stats.exec_time_p99 = percentile(exec_time_histogram_, n_exec, 0.99);
+    stats.jitter_p50 = percentile(jitter_histogram_, n_jitter, 0.5);
+    stats.jitter_p99 = percentile(jitter_histogram_, n_jitter, 0.99);
+  }
+  //-----------------------------------------------------------------------
+} //end namespace group_effort_controllers
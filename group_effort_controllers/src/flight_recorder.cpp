@@ -0,0 +1,179 @@
+#include <group_effort_controllers/flight_recorder.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <algorithm>
+
+namespace group_effort_controllers
+{
+  //-----------------------------------------------------------------------
+  FlightRecorder::FlightRecorder() : fd_(-1), map_(NULL), map_size_(0), header_(NULL), data_(NULL) {}
+  //-----------------------------------------------------------------------
+  FlightRecorder::~FlightRecorder()
+  {
+    close();
+  }
+  //-----------------------------------------------------------------------
+  //writes the whole buffer, returns false on errors
+  static bool writeAll(int fd, const void* data, size_t size)
+  {
+    const char* p = (const char*)data;
+    while(size > 0)
+      {
+	ssize_t n = ::write(fd, p, size);
+	if(n < 0 && errno == EINTR)
+	  continue;
+	if(n <= 0)
+	  return false;
+	p += n;
+	size -= n;
+      }
+    return true;
+  }
+  //-----------------------------------------------------------------------
+  bool FlightRecorder::open(const std::string& file_name, const std::vector<std::string>& joint_names, boost::uint64_t capacity)
+  {
+    close();
+    if(capacity == 0 || joint_names.empty() || file_name.empty())
+      {
+	error_ = "the flight recorder needs a file name, at least one joint and a capacity of at least one record";
+	return false;
+      }
+
+    //one shared memory object per file, e.g., /dev/shm/flight_recorder_tmp_lwr.bin for /tmp/lwr.bin
+    file_name_ = file_name;
+    std::string name = file_name;
+    std::replace(name.begin(), name.end(), '/', '_');
+    shm_name_ = "/flight_recorder" + (name[0] == '_' ? name : "_" + name);
+
+    boost::uint32_t n_joints = joint_names.size();
+    boost::uint32_t record_size = 2 + FLIGHT_RECORDER_FIELDS * n_joints;
+    boost::uint64_t data_offset = sizeof(FlightRecorderHeader) + n_joints * FLIGHT_RECORDER_NAME_LENGTH;
+    data_offset = (data_offset + 63) / 64 * 64; //cache line aligned records
+    map_size_ = data_offset + capacity * record_size * sizeof(double);
+
+    fd_ = shm_open(shm_name_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd_ < 0)
+      {
+	error_ = "could not open the shared memory object " + shm_name_ + ": " + strerror(errno);
+	return false;
+      }
+    if(ftruncate(fd_, map_size_) != 0)
+      {
+	error_ = "could not resize the shared memory object " + shm_name_ + ": " + strerror(errno);
+	close();
+	return false;
+      }
+    map_ = mmap(NULL, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if(map_ == MAP_FAILED)
+      {
+	map_ = NULL;
+	error_ = "could not map the shared memory object " + shm_name_ + ": " + strerror(errno);
+	close();
+	return false;
+      }
+
+    //touch every page so that no page faults happen in the real-time loop, and try to keep them in memory
+    memset(map_, 0, map_size_);
+    mlock(map_, map_size_);
+
+    char* names = (char*)map_ + sizeof(FlightRecorderHeader);
+    for(unsigned int i=0; i<n_joints; i++)
+      strncpy(names + i * FLIGHT_RECORDER_NAME_LENGTH, joint_names[i].c_str(), FLIGHT_RECORDER_NAME_LENGTH - 1);
+
+    header_ = (FlightRecorderHeader*)map_;
+    memcpy(header_->magic_, FLIGHT_RECORDER_MAGIC, 4);
+    header_->version_ = FLIGHT_RECORDER_VERSION;
+    header_->n_joints_ = n_joints;
+    header_->record_size_ = record_size;
+    header_->capacity_ = capacity;
+    header_->data_offset_ = data_offset;
+    header_->count_ = 0;
+    data_ = (double*)((char*)map_ + data_offset);
+    snapshot_.resize(capacity * record_size);
+
+    //start with a valid, empty file
+    if(!dump())
+      {
+	error_ = "could not write " + file_name + ": " + strerror(errno);
+	close();
+	return false;
+      }
+
+    return true;
+  }
+  //-----------------------------------------------------------------------
+  bool FlightRecorder::dump()
+  {
+    if(!header_)
+      return false;
+
+    boost::uint64_t capacity = header_->capacity_;
+    boost::uint64_t record_size = header_->record_size_;
+
+    //records count_before ... count_after may have been written while copying, into the slots of the oldest records
+    boost::uint64_t count_before = *(volatile boost::uint64_t*)&header_->count_;
+    boost::atomic_thread_fence(boost::memory_order_acquire);
+    memcpy(&snapshot_[0], data_, snapshot_.size() * sizeof(double));
+    boost::atomic_thread_fence(boost::memory_order_acquire);
+    boost::uint64_t count_after = *(volatile boost::uint64_t*)&header_->count_;
+
+    boost::uint64_t first = (count_before > capacity) ? count_before - capacity : 0;
+    if(count_after + 1 > capacity)
+      first = std::max(first, count_after + 1 - capacity);
+    boost::uint64_t n_records = (count_before > first) ? count_before - first : 0;
+
+    //the complete records form a full ring of their own, record k is stored at k % n_records as before
+    FlightRecorderHeader header = *header_;
+    header.capacity_ = std::max(n_records, (boost::uint64_t)1);
+    header.count_ = count_before;
+
+    //write a temporary file and rename it, so that the file is always complete
+    std::string tmp_name = file_name_ + ".tmp";
+    int fd = ::open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+      return false;
+
+    bool ok = writeAll(fd, &header, sizeof(header)) &&
+      writeAll(fd, (char*)map_ + sizeof(header), header.data_offset_ - sizeof(header));
+    for(boost::uint64_t i=0; ok && i<n_records; i++)
+      {
+	boost::uint64_t k = first + (i + n_records - first % n_records) % n_records;
+	ok = writeAll(fd, &snapshot_[(k % capacity) * record_size], record_size * sizeof(double));
+      }
+    if(ok && n_records == 0)
+      {
+	std::vector<double> empty(record_size, 0.0);
+	ok = writeAll(fd, &empty[0], record_size * sizeof(double));
+      }
+    ok = (::close(fd) == 0) && ok;
+
+    return ok && rename(tmp_name.c_str(), file_name_.c_str()) == 0;
+  }
+  //-----------------------------------------------------------------------
+  void FlightRecorder::close()
+  {
+    if(map_)
+      {
+	if(header_)
+	  dump();
+	munlock(map_, map_size_);
+	munmap(map_, map_size_);
+      }
+    if(fd_ >= 0)
+      {
+	::close(fd_);
+	shm_unlink(shm_name_.c_str());
+      }
+
+    fd_ = -1;
+    map_ = NULL;
+    header_ = NULL;
+    data_ = NULL;
+    map_size_ = 0;
+  }
+  //-----------------------------------------------------------------------
+} //end namespace group_effort_controllers
@@ -0,0 +1,166 @@
+/**Converts a flight recorder file written by the JointGroupVelocityController to CSV and prints tracking error and step response statistics per joint.*/
+#include <group_effort_controllers/flight_recorder.h>
+#include <group_effort_controllers/step_response.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+using namespace group_effort_controllers;
+
+//---------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    if(argc < 2 || argc > 3)
+    {
+        std::cerr<<"Usage: "<<argv[0]<<" <flight recorder file> [<csv file>]"<<std::endl;
+        std::cerr<<"Writes the recorded cycles as CSV to the given file (or stdout) and prints tracking error and step response statistics."<<std::endl;
+        std::cerr<<"The flight recorder file can also be the shared memory object the controller records into (/dev/shm/flight_recorder_...)."<<std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::in | std::ios::binary);
+    if(!in)
+    {
+        std::cerr<<"Could not open "<<argv[1]<<std::endl;
+        return 1;
+    }
+    std::vector<char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    //CHECK THE HEADER
+    if(file.size() < sizeof(FlightRecorderHeader))
+    {
+        std::cerr<<argv[1]<<" is too small to be a flight recorder file."<<std::endl;
+        return 1;
+    }
+    FlightRecorderHeader header;
+    memcpy(&header, &file[0], sizeof(header));
+    if(memcmp(header.magic_, FLIGHT_RECORDER_MAGIC, 4) != 0 || header.version_ != FLIGHT_RECORDER_VERSION)
+    {
+        std::cerr<<argv[1]<<" is not a flight recorder file of version "<<FLIGHT_RECORDER_VERSION<<"."<<std::endl;
+        return 1;
+    }
+    unsigned int n = header.n_joints_;
+    if(header.record_size_ != 2 + FLIGHT_RECORDER_FIELDS * n || header.capacity_ == 0 ||
+       file.size() < header.data_offset_ + header.capacity_ * header.record_size_ * sizeof(double))
+    {
+        std::cerr<<argv[1]<<" is corrupted."<<std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> joint_names(n);
+    for(unsigned int j=0; j<n; j++)
+    {
+        const char* name = &file[sizeof(FlightRecorderHeader) + j * FLIGHT_RECORDER_NAME_LENGTH];
+        joint_names[j] = std::string(name, strnlen(name, FLIGHT_RECORDER_NAME_LENGTH));
+    }
+
+    //WRITE THE CSV, OLDEST RECORD FIRST
+    std::ofstream csv_file;
+    if(argc == 3)
+    {
+        csv_file.open(argv[2]);
+        if(!csv_file)
+        {
+            std::cerr<<"Could not open "<<argv[2]<<std::endl;
+            return 1;
+        }
+    }
+    std::ostream& csv = (argc == 3) ? csv_file : std::cout;
+    std::ostream& stats = (argc == 3) ? std::cout : std::cerr;
+
+    const char* fields[FLIGHT_RECORDER_FIELDS] = {"set_point", "velocity", "effort", "command", "p_term", "i_term", "d_term"};
+    csv<<"stamp,time_step";
+    for(unsigned int f=0; f<FLIGHT_RECORDER_FIELDS; f++)
+        for(unsigned int j=0; j<n; j++)
+            csv<<","<<joint_names[j]<<"_"<<fields[f];
+    csv<<std::endl;
+
+    boost::uint64_t n_records = std::min(header.count_, header.capacity_);
+    boost::uint64_t first = header.count_ - n_records;
+    std::vector<double> e_sum(n, 0.0), e_sq_sum(n, 0.0), e_max(n, 0.0), cmd_max(n, 0.0);
+    std::vector<double> rec(header.record_size_);
+    std::vector<double> t(n_records);
+    std::vector<std::vector<double> > set_points(n, std::vector<double>(n_records)), velocities(n, std::vector<double>(n_records));
+    double t_first = 0.0, t_last = 0.0;
+
+    csv<<std::setprecision(12);
+    for(boost::uint64_t k=first; k<header.count_; k++)
+    {
+        memcpy(&rec[0], &file[header.data_offset_ + (k % header.capacity_) * header.record_size_ * sizeof(double)], header.record_size_ * sizeof(double));
+
+        csv<<rec[0];
+        for(unsigned int i=1; i<rec.size(); i++)
+            csv<<","<<rec[i];
+        csv<<std::endl;
+
+        if(k == first)
+            t_first = rec[0];
+        t_last = rec[0];
+        t[k - first] = rec[0];
+        for(unsigned int j=0; j<n; j++)
+        {
+            set_points[j][k - first] = rec[2 + j];
+            velocities[j][k - first] = rec[2 + n + j];
+            double e = rec[2 + j] - rec[2 + n + j];
+            e_sum[j] += e;
+            e_sq_sum[j] += e * e;
+            e_max[j] = std::max(e_max[j], std::fabs(e));
+            cmd_max[j] = std::max(cmd_max[j], std::fabs(rec[2 + 3 * n + j]));
+        }
+    }
+
+    //TRACKING ERROR STATISTICS
+    stats<<n_records<<" records ("<<header.count_<<" written in total), spanning "<<t_last - t_first<<" s."<<std::endl;
+    if(n_records == 0)
+        return 0;
+
+    stats<<std::left<<std::setw(24)<<"joint"<<std::setw(14)<<"mean(e)"<<std::setw(14)<<"rms(e)"<<std::setw(14)<<"max|e|"<<std::setw(14)<<"max|command|"<<std::endl;
+    for(unsigned int j=0; j<n; j++)
+        stats<<std::setw(24)<<joint_names[j]<<std::setw(14)<<e_sum[j] / n_records<<std::setw(14)<<std::sqrt(e_sq_sum[j] / n_records)
+             <<std::setw(14)<<e_max[j]<<std::setw(14)<<cmd_max[j]<<std::endl;
+
+    //STEP RESPONSES
+    stats<<std::endl<<std::setw(24)<<"joint"<<std::setw(14)<<"steps"<<std::setw(14)<<"rise time"<<std::setw(14)<<"overshoot %"<<std::setw(14)<<"settling time"<<std::endl;
+    for(unsigned int j=0; j<n; j++)
+    {
+        std::vector<StepResponse> responses = stepResponses(t, set_points[j], velocities[j]);
+        double rise_sum = 0.0, settling_max = 0.0, overshoot_max = 0.0;
+        unsigned int n_rise = 0, n_unsettled = 0;
+        for(unsigned int s=0; s<responses.size(); s++)
+        {
+            if(responses[s].rise_time_ >= 0.0)
+            {
+                rise_sum += responses[s].rise_time_;
+                n_rise++;
+            }
+            if(responses[s].settling_time_ >= 0.0)
+                settling_max = std::max(settling_max, responses[s].settling_time_);
+            else
+                n_unsettled++;
+            overshoot_max = std::max(overshoot_max, responses[s].overshoot_);
+        }
+
+        stats<<std::setw(24)<<joint_names[j]<<std::setw(14)<<responses.size();
+        if(responses.empty())
+        {
+            stats<<std::endl;
+            continue;
+        }
+        if(n_rise > 0)
+            stats<<std::setw(14)<<rise_sum / n_rise;
+        else
+            stats<<std::setw(14)<<"-";
+        stats<<std::setw(14)<<100.0 * overshoot_max;
+        if(n_unsettled == 0)
+            stats<<std::setw(14)<<settling_max<<std::endl;
+        else
+            stats<<n_unsettled<<" unsettled"<<std::endl;
+    }
+    stats<<"(mean 10-90% rise time, maximum overshoot, maximum time until the velocity stays within 2% of the step, per joint)"<<std::endl;
+
+    return 0;
+}
+//---------------------------------------------------------------------
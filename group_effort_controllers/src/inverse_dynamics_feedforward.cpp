@@ -0,0 +1,133 @@
+#include <group_effort_controllers/inverse_dynamics_feedforward.h>
+#include <kdl_parser/kdl_parser.hpp>
+#include <cmath>
+
+namespace group_effort_controllers
+{
+  //-----------------------------------------------------------------------
+  InverseDynamicsFeedforward::InverseDynamicsFeedforward() : enabled_(false), gain_(1.0), acceleration_cutoff_(20.0) {}
+  //-----------------------------------------------------------------------
+  bool InverseDynamicsFeedforward::init(ros::NodeHandle& n, const std::vector<std::string>& joint_names)
+  {
+    ros::NodeHandle ff_n(n, "feedforward");
+    ff_n.param("enabled", enabled_, false);
+    efforts_.setZero(joint_names.size());
+    if(!enabled_)
+      return true;
+
+    ff_n.param("gain", gain_, 1.0);
+    ff_n.param("acceleration_cutoff", acceleration_cutoff_, 20.0);
+    if(acceleration_cutoff_ <= 0.0)
+      {
+	ROS_ERROR("The feedforward acceleration_cutoff has to be positive (namespace: %s).", ff_n.getNamespace().c_str());
+	return false;
+      }
+
+    std::string root_name, tip_name;
+    if(!ff_n.getParam("root_name", root_name) || !ff_n.getParam("tip_name", tip_name))
+      {
+	ROS_ERROR("No root_name/tip_name given for the feedforward chain (namespace: %s).", ff_n.getNamespace().c_str());
+	return false;
+      }
+
+    std::vector<double> gravity, default_gravity(3, 0.0);
+    default_gravity[2] = -9.81;
+    ff_n.param("gravity", gravity, default_gravity);
+    if(gravity.size() != 3)
+      {
+	ROS_ERROR("The feedforward gravity has to be a 3-vector (namespace: %s).", ff_n.getNamespace().c_str());
+	return false;
+      }
+
+    //BUILD THE CHAIN FROM THE URDF
+    std::string description_name, robot_description;
+    if(!n.searchParam("robot_description", description_name) || !n.getParam(description_name, robot_description))
+      {
+	ROS_ERROR("Could not find the robot_description for the feedforward chain.");
+	return false;
+      }
+    KDL::Tree tree;
+    if(!kdl_parser::treeFromString(robot_description, tree))
+      {
+	ROS_ERROR("Could not parse the robot_description into a KDL tree.");
+	return false;
+      }
+    if(!tree.getChain(root_name, tip_name, chain_))
+      {
+	ROS_ERROR("Could not extract the chain from %s to %s.", root_name.c_str(), tip_name.c_str());
+	return false;
+      }
+
+    //MAP THE CHAIN JOINTS TO THE GROUP JOINTS
+    chain_to_group_.clear();
+    for(unsigned int s=0; s<chain_.getNrOfSegments(); s++)
+      {
+	const KDL::Joint& joint = chain_.getSegment(s).getJoint();
+	if(joint.getType() == KDL::Joint::None)
+	  continue;
+
+	unsigned int i;
+	for(i=0; i<joint_names.size(); i++)
+	  if(joint_names[i] == joint.getName())
+	    break;
+
+	if(i == joint_names.size())
+	  {
+	    ROS_ERROR("Chain joint %s is not controlled by the group - can't compute the feedforward.", joint.getName().c_str());
+	    return false;
+	  }
+	chain_to_group_.push_back(i);
+      }
+
+    //PREALLOCATE THE SOLVER
+    unsigned int n_chain = chain_.getNrOfJoints();
+    solver_.reset(new KDL::ChainIdSolver_RNE(chain_, KDL::Vector(gravity[0], gravity[1], gravity[2])));
+    q_.resize(n_chain);
+    qd_.resize(n_chain);
+    qdd_.resize(n_chain);
+    tau_.resize(n_chain);
+    f_ext_.assign(chain_.getNrOfSegments(), KDL::Wrench::Zero());
+    last_commands_.setZero(joint_names.size());
+
+    return true;
+  }
+  //-----------------------------------------------------------------------
+  void InverseDynamicsFeedforward::reset(const Eigen::Ref<const Eigen::VectorXd>& commands)
+  {
+    if(!enabled_)
+      return;
+
+    last_commands_ = commands;
+    qdd_.data.setZero();
+    efforts_.setZero();
+  }
+  //-----------------------------------------------------------------------
+  const Eigen::ArrayXd& InverseDynamicsFeedforward::compute(const Eigen::Ref<const Eigen::ArrayXd>& positions, const Eigen::Ref<const Eigen::VectorXd>& commands, double dt)
+  {
+    if(!enabled_ || !(dt > 0.0))
+      return efforts_;
+
+    //first order low-pass on the differentiated commands
+    double alpha = 1.0 - std::exp(-2.0 * M_PI * acceleration_cutoff_ * dt);
+    for(unsigned int j=0; j<chain_to_group_.size(); j++)
+      {
+	unsigned int i = chain_to_group_[j];
+	q_(j) = positions(i);
+	qd_(j) = commands(i);
+	qdd_(j) += alpha * ((commands(i) - last_commands_(i)) / dt - qdd_(j));
+      }
+    last_commands_ = commands;
+
+    if(solver_->CartToJnt(q_, qd_, qdd_, f_ext_, tau_) < 0)
+      {
+	efforts_.setZero();
+	return efforts_;
+      }
+
+    for(unsigned int j=0; j<chain_to_group_.size(); j++)
+      efforts_(chain_to_group_[j]) = gain_ * tau_(j);
+
+    return efforts_;
+  }
+  //-----------------------------------------------------------------------
+} //end namespace group_effort_controllers
@@ -1,30 +1,79 @@
 #include <group_effort_controllers/joint_group_velocity_controller.h>
 #include <pluginlib/class_list_macros.h>
+#include <algorithm>
 
 namespace group_effort_controllers
 {
   //-----------------------------------------------------------------------
-  JointGroupVelocityController::JointGroupVelocityController() {}
+  template <int N, class HardwareInterface>
+  GenericJointGroupVelocityController<N, HardwareInterface>::GenericJointGroupVelocityController() : reset_commands_(false), read_positions_(false), publish_rate_(PUBLISH_RATE), integrator_seed_(SEED_NONE), command_ramp_(0.0) {}
   //-----------------------------------------------------------------------
-  JointGroupVelocityController::~JointGroupVelocityController() {}
+  template <int N, class HardwareInterface>
+  GenericJointGroupVelocityController<N, HardwareInterface>::~GenericJointGroupVelocityController() {}
   //-----------------------------------------------------------------------
-  bool JointGroupVelocityController::init(hardware_interface::EffortJointInterface *hw, ros::NodeHandle &n)
+  template <int N, class HardwareInterface>
+  bool GenericJointGroupVelocityController<N, HardwareInterface>::init(HardwareInterface *hw, ros::NodeHandle &n)
   {
     n_ = n;
-    // Get the list of controlled joints
-    std::string param_name = "joints";
-    if(!n.getParam(param_name, joint_names_))
+    // Get the list of controlled joints, either directly or as several named groups stored back to back
+    std::vector<std::string> group_names, gain_namespaces;
+    if(n.getParam("groups", group_names))
       {
-        ROS_ERROR_STREAM("Failed to getParam '" << param_name << "' (namespace: " << n.getNamespace() << ").");
-        return false;
+	for(unsigned int g=0; g<group_names.size(); g++)
+	  {
+	    ros::NodeHandle group_n(n, group_names[g]);
+	    std::vector<std::string> names;
+	    if(!group_n.getParam("joints", names) || names.empty())
+	      {
+		ROS_ERROR_STREAM("Failed to getParam 'joints' of group " << group_names[g] << " (namespace: " << group_n.getNamespace() << ").");
+		return false;
+	      }
+	    JointGroup group;
+	    group.name_ = group_names[g];
+	    group.offset_ = joint_names_.size();
+	    group.size_ = names.size();
+	    groups_.push_back(group);
+	    for(unsigned int i=0; i<names.size(); i++)
+	      {
+		if(std::find(joint_names_.begin(), joint_names_.end(), names[i]) != joint_names_.end())
+		  {
+		    ROS_ERROR("Joint %s is in more than one group!", names[i].c_str());
+		    return false;
+		  }
+		joint_names_.push_back(names[i]);
+		gain_namespaces.push_back(group_names[g] + "/pid_" + names[i]);
+	      }
+	  }
+	if(groups_.empty())
+	  {
+	    ROS_ERROR("The groups parameter is empty (namespace: %s).", n.getNamespace().c_str());
+	    return false;
+	  }
+      }
+    else
+      {
+	std::string param_name = "joints";
+	if(!n.getParam(param_name, joint_names_))
+	  {
+	    ROS_ERROR_STREAM("Failed to getParam '" << param_name << "' (namespace: " << n.getNamespace() << ").");
+	    return false;
+	  }
+	for(unsigned int i=0; i<joint_names_.size(); i++)
+	  gain_namespaces.push_back("pid_" + joint_names_[i]);
       }
     n_joints_ = joint_names_.size();
+    if(N != Eigen::Dynamic && n_joints_ != (unsigned int)N)
+      {
+	ROS_ERROR("Got %d joints, but the controller is compiled for %d joints - use the JointGroupVelocityController for groups of other sizes.", n_joints_, N);
+	return false;
+      }
 
+    JointStorage<hardware_interface::JointHandle, N>::resize(joints_, n_joints_);
     for(unsigned int i=0; i<n_joints_; i++)
       {
         try
 	  {
-            joints_.push_back(hw->getHandle(joint_names_[i]));
+            joints_[i] = hw->getHandle(joint_names_[i]);
 	  }
         catch (const hardware_interface::HardwareInterfaceException& e)
 	  {
@@ -33,91 +82,423 @@ namespace group_effort_controllers
 	  }
       }
 
-    //initialize the PID controllers
-    std::string pid_ = ("pid_");
-    pids_.resize(n_joints_);
-    for (unsigned int i=0; i<n_joints_;i++)
-      if (!pids_[i].init(ros::NodeHandle(n, pid_ + joints_[i].getName())))
-	{
-	  ROS_ERROR("Error initializing the PID for joint %d",i);
-	  return false;
-	}
+    measured_velocities_.setZero(n_joints_);
+    velocities_.setZero(n_joints_);
+    errors_.setZero(n_joints_);
+    last_velocities_.setZero(n_joints_);
+    positions_.setZero(n_joints_);
+    commanded_efforts_.setZero(n_joints_);
+    zero_terms_.setZero(n_joints_);
 
-    // Start realtime state publishers
-    for (unsigned int i=0; i<n_joints_;i++)
+    //the effort path - PID, gain schedule, feedforward and disturbance observer stay disabled in the passthrough
+    if(!PASSTHROUGH)
       {
-	boost::shared_ptr<realtime_tools::RealtimePublisher<control_msgs::JointControllerState> > ptr( new realtime_tools::RealtimePublisher<control_msgs::JointControllerState>(n, joints_[i].getName()+"/state", 1));
-	c_state_pub_.push_back(ptr);
+	//initialize the PID controllers
+	if(!pid_.init(n, joint_names_, gain_namespaces))
+	  {
+	    ROS_ERROR("Error initializing the group PID controller");
+	    return false;
+	  }
+	pending_gains_ = pid_.getGains();
+	gains_buffer_.initialize(pending_gains_);
+
+	//initialize the gain schedule
+	if(!gain_schedule_.init(n, joint_names_))
+	  {
+	    ROS_ERROR("Error initializing the gain schedule");
+	    return false;
+	  }
+	scheduled_gains_ = pending_gains_;
+
+	//initialize the feedforward
+	if(!feedforward_.init(n, joint_names_))
+	  {
+	    ROS_ERROR("Error initializing the inverse dynamics feedforward");
+	    return false;
+	  }
+
+	//initialize the disturbance observer
+	if(!disturbance_observer_.init(n, joint_names_))
+	  {
+	    ROS_ERROR("Error initializing the disturbance observer");
+	    return false;
+	  }
+      }
+
+    //initialize the velocity estimation
+    if(!velocity_filter_.init(n, n_joints_))
+      {
+	ROS_ERROR("Error initializing the velocity filter");
+	return false;
+      }
+    read_positions_ = feedforward_.isEnabled() || velocity_filter_.needsPositions() || gain_schedule_.isEnabled();
+
+    //preallocate the command buffers so that neither the callbacks nor update() have to allocate
+    int max_points;
+    n.param("trajectory/max_points", max_points, 100);
+    n.param("trajectory/max_extrapolation", max_extrapolation_, 0.1);
+    if(max_points < 1 || max_extrapolation_ < 0.0)
+      {
+	ROS_ERROR("Invalid trajectory command parameters - need max_points >= 1 and max_extrapolation >= 0 (namespace: %s).", n.getNamespace().c_str());
+	return false;
       }
+    pending_commands_ = VectorN::Zero(n_joints_);
+    commands_ = VectorN::Zero(n_joints_);
+    msg_index_.resize(n_joints_);
+    VelocityTrajectory<N> trajectory;
+    trajectory.resize(n_joints_, max_points);
+    commands_buffer_.initialize(trajectory);
 
+    //bumpless start
+    std::string integrator_seed;
+    n.param<std::string>("bumpless/integrator_seed", integrator_seed, "none");
+    n.param("bumpless/command_ramp", command_ramp_, 0.0);
+    if(integrator_seed == "none")
+      integrator_seed_ = SEED_NONE;
+    else if(integrator_seed == "command")
+      integrator_seed_ = SEED_COMMAND;
+    else if(integrator_seed == "effort")
+      integrator_seed_ = SEED_EFFORT;
+    else
+      {
+	ROS_ERROR("Unknown bumpless integrator_seed %s - use none, command or effort (namespace: %s).", integrator_seed.c_str(), n.getNamespace().c_str());
+	return false;
+      }
+    if(command_ramp_ < 0.0 || (command_ramp_ > 0.0 && max_points < 3))
+      {
+	ROS_ERROR("Invalid bumpless command_ramp - need command_ramp >= 0, and trajectory/max_points >= 3 for a ramp (namespace: %s).", n.getNamespace().c_str());
+	return false;
+      }
+    seed_efforts_.setZero(n_joints_);
+    if(!PASSTHROUGH && integrator_seed_ != SEED_NONE && !disturbance_observer_.isEnabled())
+      {
+	//GroupPid clamps the seed to the i_clamp bounds, which default to zero
+	const typename GroupPid<N>::Gains& gains = pid_.getGains();
+	for(unsigned int i=0; i<n_joints_; i++)
+	  if(gains.i_min_(i) == 0.0 && gains.i_max_(i) == 0.0)
+	    ROS_WARN("bumpless/integrator_seed is %s, but joint %s has zero i_clamp bounds, so its integrator can't be seeded and it starts from zero effort (namespace: %s).",
+		     integrator_seed.c_str(), joint_names_[i].c_str(), n.getNamespace().c_str());
+      }
+
+    // Start realtime state publisher and preallocate the message
+    n.param("publish_rate", publish_rate_, (double)PUBLISH_RATE);
+    if(publish_rate_ < 0.0)
+      {
+	ROS_ERROR("publish_rate has to be positive or 0 to disable the state topic (namespace: %s).", n.getNamespace().c_str());
+	return false;
+      }
+    if(publish_rate_ > 0.0)
+      {
+	publish_period_ = ros::Duration(1.0/publish_rate_);
+	c_state_pub_.reset(new realtime_tools::RealtimePublisher<JointGroupControllerState>(n, "state", 1));
+	c_state_pub_->lock();
+	c_state_pub_->msg_.joint_names = joint_names_;
+	for(unsigned int g=0; g<groups_.size(); g++)
+	  {
+	    c_state_pub_->msg_.group_names.push_back(groups_[g].name_);
+	    c_state_pub_->msg_.group_sizes.push_back(groups_[g].size_);
+	  }
+	c_state_pub_->msg_.set_point.resize(n_joints_, 0.0);
+	c_state_pub_->msg_.process_value.resize(n_joints_, 0.0);
+	c_state_pub_->msg_.process_value_dot.resize(n_joints_, 0.0);
+	c_state_pub_->msg_.error.resize(n_joints_, 0.0);
+	c_state_pub_->msg_.command.resize(n_joints_, 0.0);
+	c_state_pub_->msg_.p.resize(n_joints_, 0.0);
+	c_state_pub_->msg_.i.resize(n_joints_, 0.0);
+	c_state_pub_->msg_.d.resize(n_joints_, 0.0);
+	c_state_pub_->msg_.i_clamp_min.resize(n_joints_, 0.0);
+	c_state_pub_->msg_.i_clamp_max.resize(n_joints_, 0.0);
+	c_state_pub_->unlock();
+      }
+
+    // Cycle timing statistics
+    ros::NodeHandle stats_n(n, "statistics");
+    double nominal_period, budget, bin_width, statistics_rate;
+    int n_bins;
+    stats_n.param("nominal_period", nominal_period, 0.001);
+    stats_n.param("budget", budget, nominal_period);
+    stats_n.param("bin_width", bin_width, 1e-5);
+    stats_n.param("n_bins", n_bins, 200);
+    stats_n.param("publish_rate", statistics_rate, 1.0);
+    if(nominal_period <= 0.0 || bin_width <= 0.0 || n_bins < 1)
+      {
+	ROS_ERROR("Invalid cycle statistics parameters (namespace: %s).", stats_n.getNamespace().c_str());
+	return false;
+      }
+    cycle_monitor_.init(nominal_period, budget, bin_width, n_bins);
+    if(statistics_rate > 0.0)
+      {
+	statistics_pub_ = n.advertise<CycleStatistics>("cycle_statistics", 1);
+	statistics_timer_ = n.createWallTimer(ros::WallDuration(1.0/statistics_rate), &GenericJointGroupVelocityController::publishStatisticsCB, this);
+      }
+
+    // Full-rate telemetry
+    if(!telemetry_.init(n, joint_names_))
+      {
+	ROS_ERROR("Error initializing the controller telemetry");
+	return false;
+      }
+
+    // Flight recorder
+    std::string recorder_file;
+    n.param<std::string>("flight_recorder/file_name", recorder_file, "");
+    if(!recorder_file.empty())
+      {
+	int capacity;
+	double dump_period;
+	n.param("flight_recorder/capacity", capacity, 10000);
+	n.param("flight_recorder/dump_period", dump_period, 0.0);
+	if(capacity < 1 || dump_period < 0.0 || !flight_recorder_.open(recorder_file, joint_names_, capacity))
+	  {
+	    ROS_ERROR("Error initializing the flight recorder: %s", flight_recorder_.getError().c_str());
+	    return false;
+	  }
+	efforts_.setZero(n_joints_);
+
+	//the cycles are recorded in shared memory, the file is written outside of the real-time loop
+	ROS_INFO("Flight recorder: recording to the shared memory object %s, dumped to %s.", flight_recorder_.getSharedMemoryName().c_str(), recorder_file.c_str());
+	if(dump_period > 0.0)
+	  flight_recorder_timer_ = n.createWallTimer(ros::WallDuration(dump_period), &GenericJointGroupVelocityController::dumpFlightRecorderCB, this);
+      }
 
     //============================================== REGISTER CALLBACKS =========================================
 
- for (unsigned int i=0; i<n_joints_;i++)
-   {
-     boost::shared_ptr<ros::Subscriber> ptr(new ros::Subscriber(n.subscribe<std_msgs::Float64>(joints_[i].getName()+"/command", 1, boost::bind(&JointGroupVelocityController::setCommandCB, this, _1, i))));
-	// sub[i] = node.subscribe(sub_name, 1, boost::bind(&MyClass::callback, this, _1, i));
-     command_sub_.push_back(ptr);
-   }
+    //all joint velocities in one message
+    group_command_sub_ = n.subscribe<std_msgs::Float64MultiArray>("command", 1, boost::bind(&GenericJointGroupVelocityController::setGroupCommandCB, this, _1, 0, n_joints_));
+
+    //gain updates for the whole group
+    if(!PASSTHROUGH)
+      set_gains_srv_ = n.advertiseService<SetGroupGains::Request, SetGroupGains::Response>("set_gains", boost::bind(&GenericJointGroupVelocityController::setGainsCB, this, _1, _2, 0, n_joints_));
+
+    //the velocities and gains of each named group
+    for(unsigned int g=0; g<groups_.size(); g++)
+      {
+	ros::NodeHandle group_n(n, groups_[g].name_);
+	groups_[g].command_sub_ = group_n.subscribe<std_msgs::Float64MultiArray>("command", 1, boost::bind(&GenericJointGroupVelocityController::setGroupCommandCB, this, _1, groups_[g].offset_, groups_[g].size_));
+	if(!PASSTHROUGH)
+	  groups_[g].set_gains_srv_ = group_n.advertiseService<SetGroupGains::Request, SetGroupGains::Response>("set_gains", boost::bind(&GenericJointGroupVelocityController::setGainsCB, this, _1, _2, groups_[g].offset_, groups_[g].size_));
+      }
+
+    //time-stamped velocities for all joints
+    trajectory_command_sub_ = n.subscribe<trajectory_msgs::JointTrajectory>("command_trajectory", 1, &GenericJointGroupVelocityController::setTrajectoryCommandCB, this);
+
+    //optionally, also listen on one topic per joint
+    bool legacy_command_topics;
+    n.param<bool>("legacy_command_topics", legacy_command_topics, false);
+    if(legacy_command_topics)
+      for (unsigned int i=0; i<n_joints_;i++)
+	{
+	  boost::shared_ptr<ros::Subscriber> ptr(new ros::Subscriber(n.subscribe<std_msgs::Float64>(joints_[i].getName()+"/command", 1, boost::bind(&GenericJointGroupVelocityController::setCommandCB, this, _1, i))));
+	  command_sub_.push_back(ptr);
+	}
 
     return true;
   }
 
   //-----------------------------------------------------------------------
-  void JointGroupVelocityController::starting(const ros::Time& time)
+  template <int N, class HardwareInterface>
+  void GenericJointGroupVelocityController<N, HardwareInterface>::starting(const ros::Time& time)
   {
-    // Start controller with 0.0 velocities
-    commands_.resize(n_joints_);
-    commands_.setZero();
-    for (unsigned int i=0; i<n_joints_;i++)
-      pids_[i].reset();
+    for(unsigned int i=0; i<n_joints_; i++)
+      {
+	positions_(i) = joints_[i].getPosition();
+	measured_velocities_(i) = joints_[i].getVelocity();
+      }
+
+    // Start controller with 0.0 velocities, or ramp down from the measured ones
+    commands_buffer_.update();
+    if(command_ramp_ > 0.0)
+      {
+	VelocityTrajectory<N>& trajectory = commands_buffer_.front();
+	trajectory.times()(0) = time.toSec();
+	trajectory.times()(1) = time.toSec() + command_ramp_;
+	trajectory.times()(2) = time.toSec() + 2.0 * command_ramp_; //flat last segment, extrapolated as zero
+	trajectory.points().col(0) = measured_velocities_.matrix();
+	trajectory.points().col(1).setZero();
+	trajectory.points().col(2).setZero();
+	trajectory.setTimed(3);
+	commands_ = measured_velocities_.matrix();
+      }
+    else
+      {
+	commands_buffer_.front().setConstant(VectorN::Zero(n_joints_));
+	commands_.setZero();
+      }
+    reset_commands_.store(true);
+
+    velocity_filter_.reset(positions_, measured_velocities_);
+    last_velocities_ = measured_velocities_;
+    disturbance_observer_.reset(measured_velocities_);
+    feedforward_.reset(commands_);
+
+    //the efforts the joints were holding when this controller took over
+    if(integrator_seed_ == SEED_COMMAND)
+      for(unsigned int i=0; i<n_joints_; i++)
+	seed_efforts_(i) = joints_[i].getCommand();
+    else if(integrator_seed_ == SEED_EFFORT)
+      for(unsigned int i=0; i<n_joints_; i++)
+	seed_efforts_(i) = joints_[i].getEffort();
+    else
+      seed_efforts_.setZero();
+
+    if(PASSTHROUGH)
+      commanded_efforts_ = commands_.array();
+    else if(integrator_seed_ != SEED_NONE)
+      {
+	//the initial velocity errors are zero, so the integral term has to supply whatever the feedforward doesn't (the
+	//feedforward was just reset, so any positive dt gives the efforts for the commanded velocities at zero acceleration)
+	commanded_efforts_ = seed_efforts_;
+	if(feedforward_.isEnabled())
+	  commanded_efforts_ -= feedforward_.compute(positions_, commands_, 1.0);
+
+	//seed either the disturbance estimate or the integrator - the observer converges to the holding efforts by itself,
+	//so a seeded integrator would add them a second time. Only what exceeds max_compensation goes into the integrator.
+	if(disturbance_observer_.isEnabled())
+	  {
+	    disturbance_observer_.reset(measured_velocities_, -commanded_efforts_);
+	    pid_.reset(commanded_efforts_ + disturbance_observer_.getEstimate());
+	  }
+	else
+	  pid_.reset(commanded_efforts_);
+	commanded_efforts_ = seed_efforts_;
+      }
+    else
+      {
+	pid_.reset();
+	commanded_efforts_.setZero();
+      }
+    last_publish_time_ = time;
   }
 
 
   //-----------------------------------------------------------------------
-  void JointGroupVelocityController::update(const ros::Time& time, const ros::Duration& period)
+  template <int N, class HardwareInterface>
+  void GenericJointGroupVelocityController<N, HardwareInterface>::update(const ros::Time& time, const ros::Duration& period)
   {
+    double cycle_start = CycleMonitor::now();
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+    Eigen::internal::set_is_malloc_allowed(false);
+#endif
+
+    //fetch the latest complete command vector - never blocks
+    commands_buffer_.update();
+    commands_buffer_.front().sample(time.toSec(), max_extrapolation_, commands_);
+    const VectorN& commands = commands_;
+
+    //read the joint states
+    for(unsigned int i=0; i<n_joints_; i++)
+      measured_velocities_(i) = joints_[i].getVelocity();
+
+    if(read_positions_)
+      for(unsigned int i=0; i<n_joints_; i++)
+	positions_(i) = joints_[i].getPosition();
+
+    //estimate the velocities
+    if(velocity_filter_.isEnabled())
+      velocities_ = velocity_filter_.update(positions_, measured_velocities_, period.toSec());
+    else
+      velocities_ = measured_velocities_;
+
+    errors_ = commands.array() - velocities_;
+
+    if(PASSTHROUGH)
+      {
+	//the hardware tracks the velocities itself
+	commanded_efforts_ = commands.array();
+      }
+    else
+      {
+	//swap in new gains for all joints at once - never blocks
+	if(gains_buffer_.update() && !gain_schedule_.isEnabled())
+	  pid_.setGains(gains_buffer_.front());
+
+	//scale the latest gains for the current configuration
+	if(gain_schedule_.isEnabled())
+	  {
+	    const typename GroupPid<N>::Gains& gains = gains_buffer_.front();
+	    const ArrayN& factors = gain_schedule_.evaluate(positions_);
+	    scheduled_gains_.p_ = factors * gains.p_;
+	    scheduled_gains_.i_ = factors * gains.i_;
+	    scheduled_gains_.d_ = factors * gains.d_;
+	    scheduled_gains_.i_min_ = gains.i_min_;
+	    scheduled_gains_.i_max_ = gains.i_max_;
+	    pid_.setGains(scheduled_gains_);
+	  }
+
+	//commanded_efforts_ still holds the efforts applied during the last period
+	if(disturbance_observer_.isEnabled())
+	  disturbance_observer_.update(velocities_, commanded_efforts_, period.toSec());
+
+	// Compute the PID commands for all joints at once with nonuniform time step size. The
+	// derivative errors are computed from the change in the errors and the timestep dt.
+	commanded_efforts_ = pid_.computeCommand(errors_, period.toSec());
+
+	if(feedforward_.isEnabled())
+	  commanded_efforts_ += feedforward_.compute(positions_, commands, period.toSec());
+
+	if(disturbance_observer_.isEnabled())
+	  commanded_efforts_ -= disturbance_observer_.getEstimate();
+      }
 
-    // Set the PID error and compute the PID command with nonuniform time
-    // step size. The derivative error is computed from the change in the error
-    // and the timestep dt.
     for(unsigned int i=0; i<n_joints_; i++)
+      joints_[i].setCommand(commanded_efforts_(i));
+
+    if(telemetry_.isEnabled())
+      telemetry_.record(time, period.toSec(), commands, velocities_, errors_, commanded_efforts_);
+
+    if(flight_recorder_.isOpen())
       {
-	double error = commands_(i) - joints_[i].getVelocity();
-	double commanded_effort = pids_[i].computeCommand(error, period);
-	joints_[i].setCommand(commanded_effort);
+	for(unsigned int i=0; i<n_joints_; i++)
+	  efforts_(i) = joints_[i].getEffort();
+
+	flight_recorder_.record(time.toSec(), period.toSec(), commands, velocities_, efforts_, commanded_efforts_,
+				PASSTHROUGH ? zero_terms_ : pid_.getPTerm(), PASSTHROUGH ? zero_terms_ : pid_.getITerm(),
+				PASSTHROUGH ? zero_terms_ : pid_.getDTerm());
       }
 
-    if (PUBLISH_RATE > 0.0 && last_publish_time_ + ros::Duration(1.0/PUBLISH_RATE) < time)
+    if (publish_rate_ > 0.0 && last_publish_time_ + publish_period_ < time)
       {
 	//increment time
-	last_publish_time_ = last_publish_time_ + ros::Duration(1.0/PUBLISH_RATE);
+	last_publish_time_ = last_publish_time_ + publish_period_;
 
 	// publish the tracking controller stuff
-	for (unsigned int i=0; i<n_joints_;i++)
+	if (c_state_pub_->trylock())
 	  {
-	    if (c_state_pub_[i]->trylock())
+	    double dt = period.toSec();
+
+	    c_state_pub_->msg_.header.stamp = time;
+	    c_state_pub_->msg_.time_step = dt;
+	    for (unsigned int i=0; i<n_joints_;i++)
 	      {
-		c_state_pub_[i]->msg_.header.stamp = time;
-		c_state_pub_[i]->msg_.set_point = commands_(i);
-		c_state_pub_[i]->msg_.process_value_dot = (c_state_pub_[i]->msg_.process_value - joints_[i].getVelocity())/period.toSec();
-		c_state_pub_[i]->msg_.process_value = joints_[i].getVelocity();
-		c_state_pub_[i]->msg_.error = commands_(i) -joints_[i].getVelocity();
-		c_state_pub_[i]->msg_.time_step = period.toSec();
-		c_state_pub_[i]->msg_.command = joints_[i].getCommand();
-
-		double dummy;
-		  pids_[i].getGains(c_state_pub_[i]->msg_.p,
-				    c_state_pub_[i]->msg_.i,
-				    c_state_pub_[i]->msg_.d,
-				    c_state_pub_[i]->msg_.i_clamp,
-				    dummy);
-
-		c_state_pub_[i]->unlockAndPublish();
+		c_state_pub_->msg_.set_point[i] = commands(i);
+		c_state_pub_->msg_.process_value[i] = velocities_(i);
+		c_state_pub_->msg_.process_value_dot[i] = (velocities_(i) - last_velocities_(i))/dt;
+		c_state_pub_->msg_.error[i] = errors_(i);
+		c_state_pub_->msg_.command[i] = commanded_efforts_(i);
 	      }
+	    //no gains in the passthrough, they stay zero
+	    if(!PASSTHROUGH)
+	      {
+		const typename GroupPid<N>::Gains& gains = pid_.getGains();
+		for (unsigned int i=0; i<n_joints_;i++)
+		  {
+		    c_state_pub_->msg_.p[i] = gains.p_(i);
+		    c_state_pub_->msg_.i[i] = gains.i_(i);
+		    c_state_pub_->msg_.d[i] = gains.d_(i);
+		    c_state_pub_->msg_.i_clamp_min[i] = gains.i_min_(i);
+		    c_state_pub_->msg_.i_clamp_max[i] = gains.i_max_(i);
+		  }
+	      }
+	    c_state_pub_->unlockAndPublish();
 	  }
       }
 
+    last_velocities_ = velocities_;
+
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+    Eigen::internal::set_is_malloc_allowed(true);
+#endif
+    cycle_monitor_.record(CycleMonitor::now() - cycle_start, period.toSec());
   }
   //-----------------------------------------------------------------------
 
@@ -126,12 +507,152 @@ namespace group_effort_controllers
   ///////////////
 
   //-----------------------------------------------------------------------
-  void JointGroupVelocityController::setCommandCB(const std_msgs::Float64ConstPtr& msg, unsigned int i)
+  template <int N, class HardwareInterface>
+  void GenericJointGroupVelocityController<N, HardwareInterface>::setCommandCB(const std_msgs::Float64ConstPtr& msg, unsigned int i)
+  {
+    boost::mutex::scoped_lock lock(command_lock_);
+    if(reset_commands_.exchange(false))
+      pending_commands_.setZero();
+
+    pending_commands_(i) = msg->data;
+    commands_buffer_.back().setConstant(pending_commands_);
+    commands_buffer_.publish();
+  }
+  //-----------------------------------------------------------------------
+  template <int N, class HardwareInterface>
+  void GenericJointGroupVelocityController<N, HardwareInterface>::setGroupCommandCB(const std_msgs::Float64MultiArrayConstPtr& msg, unsigned int offset, unsigned int size)
+  {
+    if(msg->data.size() != size)
+      {
+	ROS_ERROR("JointGroupVelocityController::setGroupCommandCB(): received %d commands, but the group has %d joints!", (int)msg->data.size(), size);
+	return;
+      }
+
+    //the other groups keep their latest constant velocities
+    boost::mutex::scoped_lock lock(command_lock_);
+    if(reset_commands_.exchange(false))
+      pending_commands_.setZero();
+
+    for(unsigned int i=0; i<size; i++)
+      pending_commands_(offset + i) = msg->data[i];
+
+    commands_buffer_.back().setConstant(pending_commands_);
+    commands_buffer_.publish();
+  }
+  //-----------------------------------------------------------------------
+  template <int N, class HardwareInterface>
+  void GenericJointGroupVelocityController<N, HardwareInterface>::setTrajectoryCommandCB(const trajectory_msgs::JointTrajectoryConstPtr& msg)
+  {
+    unsigned int n_points = msg->points.size();
+    if(n_points == 0 || n_points > commands_buffer_.back().maxPoints())
+      {
+	ROS_ERROR("JointGroupVelocityController::setTrajectoryCommandCB(): received %d points, but the trajectory has to have between 1 and %d points!", n_points, commands_buffer_.back().maxPoints());
+	return;
+      }
+    for(unsigned int k=0; k<n_points; k++)
+      if(msg->points[k].velocities.size() != (msg->joint_names.empty() ? n_joints_ : msg->joint_names.size()) ||
+	 (k > 0 && !(msg->points[k].time_from_start > msg->points[k-1].time_from_start)))
+	{
+	  ROS_ERROR("JointGroupVelocityController::setTrajectoryCommandCB(): each point needs velocities for all joints and the points have to be strictly ordered in time!");
+	  return;
+	}
+
+    //a zero stamp means now
+    ros::Time start = msg->header.stamp.isZero() ? ros::Time::now() : msg->header.stamp;
+
+    boost::mutex::scoped_lock lock(command_lock_);
+
+    //map the message joints to the group joints, no names means group order
+    for(unsigned int i=0; i<n_joints_; i++)
+      {
+	if(msg->joint_names.empty())
+	  {
+	    msg_index_[i] = i;
+	    continue;
+	  }
+	std::vector<std::string>::const_iterator it = std::find(msg->joint_names.begin(), msg->joint_names.end(), joint_names_[i]);
+	if(it == msg->joint_names.end())
+	  {
+	    ROS_ERROR("JointGroupVelocityController::setTrajectoryCommandCB(): joint %s is missing in the trajectory!", joint_names_[i].c_str());
+	    return;
+	  }
+	msg_index_[i] = it - msg->joint_names.begin();
+      }
+
+    //as in the other callbacks, so that constant commands received before starting() don't return with the next per-joint command
+    if(reset_commands_.exchange(false))
+      pending_commands_.setZero();
+
+    VelocityTrajectory<N>& trajectory = commands_buffer_.back();
+    for(unsigned int k=0; k<n_points; k++)
+      {
+	trajectory.times()(k) = (start + msg->points[k].time_from_start).toSec();
+	for(unsigned int i=0; i<n_joints_; i++)
+	  trajectory.points()(i, k) = msg->points[k].velocities[msg_index_[i]];
+      }
+    trajectory.setTimed(n_points);
+    commands_buffer_.publish();
+  }
+
+  //-----------------------------------------------------------------------
+  template <int N, class HardwareInterface>
+  bool GenericJointGroupVelocityController<N, HardwareInterface>::setGainsCB(SetGroupGains::Request& req, SetGroupGains::Response& res, unsigned int offset, unsigned int size)
   {
-    commands_(i) = msg->data;
-}
+    const std::vector<double>* values[5] = {&req.p, &req.i, &req.d, &req.i_clamp_min, &req.i_clamp_max};
+    for(unsigned int k=0; k<5; k++)
+      if(!values[k]->empty() && values[k]->size() != size)
+	{
+	  res.success = false;
+	  res.message = "each gain array has to be empty or contain one value per joint of the group";
+	  return true;
+	}
+
+    boost::mutex::scoped_lock lock(gains_lock_);
+    typename GroupPid<N>::Gains gains = pending_gains_;
+    for(unsigned int i=0; i<size; i++)
+      {
+	if(!req.p.empty()) gains.p_(offset + i) = req.p[i];
+	if(!req.i.empty()) gains.i_(offset + i) = req.i[i];
+	if(!req.d.empty()) gains.d_(offset + i) = req.d[i];
+	if(!req.i_clamp_min.empty()) gains.i_min_(offset + i) = req.i_clamp_min[i];
+	if(!req.i_clamp_max.empty()) gains.i_max_(offset + i) = req.i_clamp_max[i];
+      }
+    if((gains.i_min_ > gains.i_max_).any())
+      {
+	res.success = false;
+	res.message = "i_clamp_min is larger than i_clamp_max";
+	return true;
+      }
 
+    pending_gains_ = gains;
+    gains_buffer_.write(pending_gains_);
+    res.success = true;
+    return true;
+  }
+  //-----------------------------------------------------------------------
+  template <int N, class HardwareInterface>
+  void GenericJointGroupVelocityController<N, HardwareInterface>::publishStatisticsCB(const ros::WallTimerEvent& event)
+  {
+    cycle_monitor_.getStatistics(statistics_);
+    statistics_.header.stamp = ros::Time::now();
+    statistics_pub_.publish(statistics_);
+  }
+  //-----------------------------------------------------------------------
+  template <int N, class HardwareInterface>
+  void GenericJointGroupVelocityController<N, HardwareInterface>::dumpFlightRecorderCB(const ros::WallTimerEvent& event)
+  {
+    if(!flight_recorder_.dump())
+      ROS_WARN("Could not dump the flight recorder.");
+  }
+  //-----------------------------------------------------------------------
+  template class GenericJointGroupVelocityController<Eigen::Dynamic>;
+  template class GenericJointGroupVelocityController<7>;
+  template class GenericJointGroupVelocityController<8>;
+  template class GenericJointGroupVelocityController<Eigen::Dynamic, hardware_interface::VelocityJointInterface>;
   //-----------------------------------------------------------------------
 } //end namespace hqp_controllers
 
 PLUGINLIB_EXPORT_CLASS(group_effort_controllers::JointGroupVelocityController,controller_interface::ControllerBase)
+PLUGINLIB_EXPORT_CLASS(group_effort_controllers::JointGroupVelocityController7,controller_interface::ControllerBase)
+PLUGINLIB_EXPORT_CLASS(group_effort_controllers::JointGroupVelocityController8,controller_interface::ControllerBase)
+PLUGINLIB_EXPORT_CLASS(group_effort_controllers::JointGroupVelocityPassthroughController,controller_interface::ControllerBase)
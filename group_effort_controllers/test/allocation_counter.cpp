@@ -0,0 +1,92 @@
+#include "allocation_counter.h"
+#include <stddef.h>
+#include <errno.h>
+
+//glibc's implementations, which the interposed functions forward to
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t n, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* ptr);
+}
+
+static __thread bool counting_ = false;
+static __thread unsigned long count_ = 0;
+
+static inline void count()
+{
+    if(counting_)
+        count_++;
+}
+
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        count();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t n, size_t size)
+    {
+        count();
+        return __libc_calloc(n, size);
+    }
+
+    void* realloc(void* ptr, size_t size)
+    {
+        count();
+        return __libc_realloc(ptr, size);
+    }
+
+    void free(void* ptr)
+    {
+        if(ptr)
+            count();
+        __libc_free(ptr);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        count();
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        count();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** ptr, size_t alignment, size_t size)
+    {
+        count();
+        void* p = __libc_memalign(alignment, size);
+        if(!p)
+            return ENOMEM;
+        *ptr = p;
+        return 0;
+    }
+}
+
+namespace group_effort_controllers
+{
+namespace allocation_counter
+{
+    //-----------------------------------------------------------------------
+    void start()
+    {
+        count_ = 0;
+        counting_ = true;
+    }
+    //-----------------------------------------------------------------------
+    unsigned long stop()
+    {
+        counting_ = false;
+        return count_;
+    }
+    //-----------------------------------------------------------------------
+}
+} //end namespace group_effort_controllers
@@ -0,0 +1,24 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief Counts the heap calls of a thread.
+   *
+   * allocation_counter.cpp interposes malloc, calloc, realloc, free and the aligned allocation functions of glibc
+   * for the whole executable it is linked into, so operator new/delete, Eigen, the STL and ROS are all caught. Only
+   * the calls of the thread which started counting are counted, other threads (spinners, publishers) run unaffected.
+   */
+namespace allocation_counter
+{
+    /**Starts counting the heap calls of the calling thread from zero.*/
+    void start();
+    /**Stops counting and returns the number of heap calls of the calling thread since start().*/
+    unsigned long stop();
+}
+
+} //end namespace group_effort_controllers
+
+#endif
@@ -0,0 +1,366 @@
+/**Closes the loop of the JointGroupVelocityController over a simulated joint model and checks the tracking of step and
+ * ramp velocity profiles and of a recorded command profile, in simulated time and thus faster than real time. The controller configuration (joints and
+ * gains) is read from the sub-namespace controller of the test node's private namespace, the joint model from the
+ * robot_description and the private namespace, the thresholds from the private namespace, see closed_loop.test.*/
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <trajectory_msgs/JointTrajectory.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <group_effort_controllers/joint_group_velocity_controller.h>
+#include <group_effort_controllers/step_response.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <urdf/model.h>
+#include <kdl_parser/kdl_parser.hpp>
+#include <kdl/tree.hpp>
+#include <kdl/chaindynparam.hpp>
+#include "fake_joint_hardware.h"
+
+using namespace group_effort_controllers;
+
+#define CONTROL_PERIOD 0.001
+#define START_TIME 100.0 //simulated time in s at which the controller is started
+#define STEP_SIZE 0.5 //rad/s
+
+//---------------------------------------------------------------------
+/**
+   * \brief Runs the controller on a FakeJointHardware which is advanced by FakeJointHardware::simulate(...) every cycle.
+   *
+   * A velocity profile is sent as one time-stamped trajectory command, whose points are given in s relative to
+   * START_TIME and apply to all joints. Every cycle, the set point and the velocity the controller measured are logged
+   * per joint for the evaluation.
+   */
+class ClosedLoopTest : public ::testing::Test
+{
+protected:
+
+    ClosedLoopTest() : n_("~"), received_(false) {}
+
+    virtual void SetUp()
+    {
+        std::string controller_name;
+        ASSERT_TRUE(n_.getParam("controller", controller_name)) << "no controller in " << n_.getNamespace();
+        controller_n_ = ros::NodeHandle(n_, controller_name);
+        std::vector<std::string> joint_names;
+        ASSERT_TRUE(controller_n_.getParam("joints", joint_names)) << "no joints in " << controller_n_.getNamespace();
+        hw_.reset(new FakeJointHardware(joint_names));
+        ASSERT_NO_FATAL_FAILURE(loadPlant());
+        n_.param("max_rise_time", max_rise_time_, 0.05);
+        n_.param("max_overshoot", max_overshoot_, 0.05);
+        n_.param("max_settling_time", max_settling_time_, 0.2);
+        n_.param("max_ramp_rms_error", max_ramp_rms_error_, 0.02);
+        n_.param("max_recorded_rms_error", max_recorded_rms_error_, 0.02);
+
+        ASSERT_TRUE(controller_.init(&hw_->effort_interface_, controller_n_));
+        //commands received before starting(...) are discarded, so the controller is started before the profile is sent
+        controller_.starting(ros::Time(START_TIME));
+        trajectory_pub_ = controller_n_.advertise<trajectory_msgs::JointTrajectory>("command_trajectory", 1);
+        trajectory_sub_ = controller_n_.subscribe("command_trajectory", 1, &ClosedLoopTest::trajectoryCB, this);
+    }
+
+    /**
+       * Sets the joint model of hw_ from the robot_description. The inertia of each joint is the diagonal element of the
+       * joint space inertia matrix of the chain plant/root_name - plant/tip_name in the configuration
+       * plant/configuration (default: all zeros) plus the reflected rotor inertia plant/<joint>/rotor_inertia, which
+       * the URDF doesn't model. The effort limits are the URDF joint limits. Damping and friction are the URDF joint
+       * dynamics unless plant/<joint>/damping and plant/<joint>/friction are given.
+       */
+    void loadPlant()
+    {
+        ros::NodeHandle plant_n(n_, "plant");
+        std::string description_name, robot_description, root_name, tip_name;
+        ASSERT_TRUE(n_.searchParam("robot_description", description_name) && n_.getParam(description_name, robot_description)) << "no robot_description";
+        ASSERT_TRUE(plant_n.getParam("root_name", root_name) && plant_n.getParam("tip_name", tip_name)) << "no root_name/tip_name in " << plant_n.getNamespace();
+
+        urdf::Model model;
+        ASSERT_TRUE(model.initString(robot_description)) << "could not parse the robot_description";
+        KDL::Tree tree;
+        ASSERT_TRUE(kdl_parser::treeFromUrdfModel(model, tree)) << "could not build a KDL tree from the robot_description";
+        KDL::Chain chain;
+        ASSERT_TRUE(tree.getChain(root_name, tip_name, chain)) << "no chain from " << root_name << " to " << tip_name;
+
+        unsigned int n_chain = chain.getNrOfJoints();
+        KDL::JntArray q(n_chain);
+        std::vector<double> configuration;
+        if(plant_n.getParam("configuration", configuration))
+        {
+            ASSERT_EQ(n_chain, configuration.size()) << "plant/configuration needs one value per chain joint";
+            for(unsigned int j=0; j<n_chain; j++)
+                q(j) = configuration[j];
+        }
+        //gravity doesn't enter the inertia matrix
+        KDL::ChainDynParam dynamics(chain, KDL::Vector::Zero());
+        KDL::JntSpaceInertiaMatrix inertia(n_chain);
+        ASSERT_GE(dynamics.JntToMass(q, inertia), 0) << "could not compute the joint space inertia matrix";
+
+        std::cout << std::left << std::setw(24) << "joint" << std::setw(14) << "inertia" << std::setw(14) << "link inertia" << std::setw(14) << "damping"
+                  << std::setw(14) << "friction" << std::setw(14) << "effort limit" << std::endl;
+        for(unsigned int i=0; i<hw_->joint_names_.size(); i++)
+        {
+            const std::string& name = hw_->joint_names_[i];
+            int j = -1;
+            for(unsigned int s=0, k=0; s<chain.getNrOfSegments(); s++)
+            {
+                const KDL::Joint& joint = chain.getSegment(s).getJoint();
+                if(joint.getType() == KDL::Joint::None)
+                    continue;
+                if(joint.getName() == name)
+                    j = k;
+                k++;
+            }
+            ASSERT_GE(j, 0) << name << " is not in the chain from " << root_name << " to " << tip_name;
+            boost::shared_ptr<const urdf::Joint> urdf_joint = model.getJoint(name);
+            ASSERT_TRUE(urdf_joint && urdf_joint->limits) << name << " has no limits in the robot_description";
+
+            ros::NodeHandle joint_n(plant_n, name);
+            double rotor_inertia;
+            joint_n.param("rotor_inertia", rotor_inertia, 0.0);
+            hw_->inertia_[i] = inertia(j, j) + rotor_inertia;
+            hw_->effort_limit_[i] = urdf_joint->limits->effort;
+            joint_n.param("damping", hw_->damping_[i], urdf_joint->dynamics ? urdf_joint->dynamics->damping : 0.0);
+            joint_n.param("friction", hw_->friction_[i], urdf_joint->dynamics ? urdf_joint->dynamics->friction : 0.0);
+            ASSERT_GT(hw_->inertia_[i], 0.0) << name;
+
+            std::cout << std::setw(24) << name << std::setw(14) << hw_->inertia_[i] << std::setw(14) << inertia(j, j) << std::setw(14) << hw_->damping_[i]
+                      << std::setw(14) << hw_->friction_[i] << std::setw(14) << hw_->effort_limit_[i] << std::endl;
+        }
+    }
+
+    void trajectoryCB(const trajectory_msgs::JointTrajectoryConstPtr& msg) { received_ = true; }
+
+    /**Sends the profile given by the times in s after START_TIME and the velocities of all joints, returns once the controller got it.*/
+    bool sendProfile(const std::vector<double>& times, const std::vector<double>& velocities)
+    {
+        times_ = times;
+        velocities_ = velocities;
+
+        trajectory_msgs::JointTrajectory msg;
+        msg.header.stamp = ros::Time(START_TIME);
+        msg.points.resize(times.size());
+        for(unsigned int k=0; k<times.size(); k++)
+        {
+            msg.points[k].time_from_start = ros::Duration(times[k]);
+            msg.points[k].velocities.resize(hw_->joint_names_.size(), velocities[k]);
+        }
+
+        ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(10.0);
+        while(trajectory_pub_.getNumSubscribers() == 0 && ros::WallTime::now() < deadline)
+            ros::WallDuration(0.01).sleep();
+
+        //the test's own subscriber is called in the same spin as the controller's
+        received_ = false;
+        trajectory_pub_.publish(msg);
+        while(!received_ && ros::WallTime::now() < deadline)
+        {
+            ros::spinOnce();
+            ros::WallDuration(0.01).sleep();
+        }
+        return received_;
+    }
+
+    /**
+       * Reads the set points of all joints from a CSV file as written by flight_recorder_to_csv: the columns stamp and
+       * <joint>_set_point, one row per recorded cycle. The recorded times are made relative to the first row.
+       */
+    void loadRecordedProfile(const std::string& file_name)
+    {
+        std::ifstream file(file_name.c_str());
+        ASSERT_TRUE(file.good()) << "could not open " << file_name;
+
+        std::string line, cell;
+        ASSERT_TRUE(std::getline(file, line)) << file_name << " is empty";
+        std::vector<std::string> columns;
+        std::istringstream header(line);
+        while(std::getline(header, cell, ','))
+            columns.push_back(cell);
+
+        unsigned int n_joints = hw_->joint_names_.size();
+        std::vector<unsigned int> set_point_columns(n_joints);
+        unsigned int stamp_column = std::find(columns.begin(), columns.end(), "stamp") - columns.begin();
+        ASSERT_LT(stamp_column, columns.size()) << "no stamp column in " << file_name;
+        for(unsigned int i=0; i<n_joints; i++)
+        {
+            set_point_columns[i] = std::find(columns.begin(), columns.end(), hw_->joint_names_[i] + "_set_point") - columns.begin();
+            ASSERT_LT(set_point_columns[i], columns.size()) << "no set point of " << hw_->joint_names_[i] << " in " << file_name;
+        }
+
+        recorded_times_.clear();
+        recorded_set_points_.clear();
+        std::vector<double> row;
+        while(std::getline(file, line))
+        {
+            row.clear();
+            std::istringstream values(line);
+            while(std::getline(values, cell, ','))
+                row.push_back(atof(cell.c_str()));
+            ASSERT_EQ(columns.size(), row.size()) << "incomplete row " << recorded_times_.size() + 1 << " in " << file_name;
+
+            recorded_times_.push_back(row[stamp_column]);
+            recorded_set_points_.push_back(std::vector<double>(n_joints));
+            for(unsigned int i=0; i<n_joints; i++)
+                recorded_set_points_.back()[i] = row[set_point_columns[i]];
+        }
+        ASSERT_FALSE(recorded_times_.empty()) << "no recorded cycles in " << file_name;
+        for(unsigned int k=recorded_times_.size(); k-- > 0;)
+            recorded_times_[k] -= recorded_times_[0];
+    }
+
+    /**Set point of the profile at t in s after START_TIME, linearly interpolated as the controller does.*/
+    double setPoint(double t) const
+    {
+        if(t <= times_.front())
+            return velocities_.front();
+        for(unsigned int k=1; k<times_.size(); k++)
+            if(t <= times_[k])
+                return velocities_[k-1] + (velocities_[k] - velocities_[k-1]) * (t - times_[k-1]) / (times_[k] - times_[k-1]);
+
+        return velocities_.back();
+    }
+
+    /**
+       * Runs the controller from START_TIME on with the simulated joints for the given number of cycles. If a recorded
+       * profile is loaded, its rows are passed to the group command callback as soon as their time is reached, as the
+       * commands of the recording arrived, otherwise the controller follows the profile sent by sendProfile(...).
+       */
+    void run(unsigned int n_cycles)
+    {
+        unsigned int n_joints = hw_->joint_names_.size();
+        t_.resize(n_cycles);
+        set_points_.assign(n_joints, std::vector<double>(n_cycles));
+        measured_.assign(n_joints, std::vector<double>(n_cycles));
+
+        std_msgs::Float64MultiArrayPtr command(new std_msgs::Float64MultiArray);
+        command->data.resize(n_joints, 0.0);
+        unsigned int row = 0;
+
+        ros::Duration period(CONTROL_PERIOD);
+        for(unsigned int k=0; k<n_cycles; k++)
+        {
+            //k * period instead of accumulating the periods, so that the cycles hit the profile points exactly
+            t_[k] = k * CONTROL_PERIOD;
+            if(row < recorded_times_.size() && recorded_times_[row] <= t_[k] + 0.5 * CONTROL_PERIOD)
+            {
+                //the latest row up to this cycle
+                while(row + 1 < recorded_times_.size() && recorded_times_[row + 1] <= t_[k] + 0.5 * CONTROL_PERIOD)
+                    row++;
+                command->data = recorded_set_points_[row++];
+                controller_.setGroupCommandCB(command, 0, n_joints);
+            }
+            for(unsigned int i=0; i<n_joints; i++)
+            {
+                set_points_[i][k] = recorded_times_.empty() ? setPoint(t_[k]) : command->data[i];
+                measured_[i][k] = hw_->velocity_[i];
+            }
+
+            controller_.update(ros::Time(START_TIME + t_[k]), period);
+            hw_->simulate(CONTROL_PERIOD);
+        }
+    }
+
+    ros::NodeHandle n_;
+    ros::NodeHandle controller_n_; ///< namespace of the controller configuration
+    boost::scoped_ptr<FakeJointHardware> hw_;
+    JointGroupVelocityController controller_;
+    ros::Publisher trajectory_pub_;
+    ros::Subscriber trajectory_sub_;
+    bool received_;
+
+    double max_rise_time_, max_overshoot_, max_settling_time_, max_ramp_rms_error_, max_recorded_rms_error_;
+
+    std::vector<double> times_, velocities_; ///< the current profile
+    std::vector<double> recorded_times_; ///< of the recorded profile in s, relative to its first row
+    std::vector<std::vector<double> > recorded_set_points_; ///< per row and joint
+    std::vector<double> t_; ///< time of each cycle after START_TIME
+    std::vector<std::vector<double> > set_points_, measured_; ///< per joint and cycle
+};
+//---------------------------------------------------------------------
+TEST_F(ClosedLoopTest, StepResponse)
+{
+    //up at 0.1 s, down at 0.6 s, each step within one cycle
+    double t_up = 0.1, t_down = 0.6, t_end = 1.1;
+    std::vector<double> times, velocities;
+    times.push_back(t_up); velocities.push_back(0.0);
+    times.push_back(t_up + CONTROL_PERIOD); velocities.push_back(STEP_SIZE);
+    times.push_back(t_down); velocities.push_back(STEP_SIZE);
+    times.push_back(t_down + CONTROL_PERIOD); velocities.push_back(0.0);
+    times.push_back(t_end); velocities.push_back(0.0);
+    ASSERT_TRUE(sendProfile(times, velocities));
+    run((unsigned int)(t_end / CONTROL_PERIOD));
+
+    std::cout << std::left << std::setw(24) << "joint" << std::setw(14) << "rise time" << std::setw(14) << "overshoot %" << std::setw(14) << "settling time" << std::endl;
+    for(unsigned int i=0; i<hw_->joint_names_.size(); i++)
+    {
+        std::vector<StepResponse> responses = stepResponses(t_, set_points_[i], measured_[i]);
+        ASSERT_EQ(2u, responses.size()) << hw_->joint_names_[i];
+        for(unsigned int s=0; s<responses.size(); s++)
+        {
+            std::cout << std::setw(24) << hw_->joint_names_[i] << std::setw(14) << responses[s].rise_time_ << std::setw(14) << 100.0 * responses[s].overshoot_
+                      << std::setw(14) << responses[s].settling_time_ << std::endl;
+
+            EXPECT_GE(responses[s].rise_time_, 0.0) << hw_->joint_names_[i] << " doesn't reach 90% of step " << s;
+            EXPECT_LE(responses[s].rise_time_, max_rise_time_) << hw_->joint_names_[i] << ", step " << s;
+            EXPECT_LE(responses[s].overshoot_, max_overshoot_) << hw_->joint_names_[i] << ", step " << s;
+            EXPECT_GE(responses[s].settling_time_, 0.0) << hw_->joint_names_[i] << " doesn't settle after step " << s;
+            EXPECT_LE(responses[s].settling_time_, max_settling_time_) << hw_->joint_names_[i] << ", step " << s;
+        }
+    }
+}
+//---------------------------------------------------------------------
+TEST_F(ClosedLoopTest, RampTracking)
+{
+    //0.5 s up to STEP_SIZE, held for 0.3 s, 0.5 s down
+    std::vector<double> times, velocities;
+    times.push_back(0.1); velocities.push_back(0.0);
+    times.push_back(0.6); velocities.push_back(STEP_SIZE);
+    times.push_back(0.9); velocities.push_back(STEP_SIZE);
+    times.push_back(1.4); velocities.push_back(0.0);
+    times.push_back(1.5); velocities.push_back(0.0);
+    ASSERT_TRUE(sendProfile(times, velocities));
+    run((unsigned int)(1.5 / CONTROL_PERIOD));
+
+    std::cout << std::left << std::setw(24) << "joint" << std::setw(14) << "rms(e)" << std::endl;
+    for(unsigned int i=0; i<hw_->joint_names_.size(); i++)
+    {
+        //no steps to be found in a ramp
+        EXPECT_TRUE(stepResponses(t_, set_points_[i], measured_[i]).empty());
+
+        double rms = rmsError(set_points_[i], measured_[i]);
+        std::cout << std::setw(24) << hw_->joint_names_[i] << std::setw(14) << rms << std::endl;
+        EXPECT_LE(rms, max_ramp_rms_error_) << hw_->joint_names_[i];
+    }
+}
+//---------------------------------------------------------------------
+TEST_F(ClosedLoopTest, RecordedProfile)
+{
+    std::string file_name;
+    n_.param("recorded_profile", file_name, std::string());
+    if(file_name.empty())
+    {
+        std::cout << "no recorded_profile given - nothing to replay" << std::endl;
+        return;
+    }
+    ASSERT_NO_FATAL_FAILURE(loadRecordedProfile(file_name));
+    run((unsigned int)(recorded_times_.back() / CONTROL_PERIOD) + 1);
+
+    std::cout << "replayed " << recorded_times_.size() << " commands over " << recorded_times_.back() << " s from " << file_name << std::endl;
+    std::cout << std::left << std::setw(24) << "joint" << std::setw(14) << "rms(e)" << std::endl;
+    for(unsigned int i=0; i<hw_->joint_names_.size(); i++)
+    {
+        double rms = rmsError(set_points_[i], measured_[i]);
+        std::cout << std::setw(24) << hw_->joint_names_[i] << std::setw(14) << rms << std::endl;
+        EXPECT_LE(rms, max_recorded_rms_error_) << hw_->joint_names_[i];
+    }
+}
+//---------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    ros::init(argc, argv, "closed_loop_test");
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,129 @@
+#ifndef FAKE_JOINT_HARDWARE_H
+#define FAKE_JOINT_HARDWARE_H
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <ros/node_handle.h>
+#include <hardware_interface/joint_state_interface.h>
+#include <hardware_interface/joint_command_interface.h>
+
+namespace group_effort_controllers
+{
+//--------------------------------------------------------
+/**
+   * \brief In-process stand-in for the robot hardware of a joint group.
+   *
+   * Holds the position, velocity, effort and command of each joint and exposes them through an EffortJointInterface
+   * and a VelocityJointInterface, as a RobotHW would, so a controller can be run without Gazebo or the arm. The states
+   * are either set by the test itself or, for effort commands, advanced by simulate(...) with a simple joint model.
+   */
+class FakeJointHardware
+{
+public:
+
+    /**Creates n_joints joints named joint_1, joint_2, ...*/
+    explicit FakeJointHardware(unsigned int n_joints)
+    {
+        std::vector<std::string> joint_names;
+        for(unsigned int i=0; i<n_joints; i++)
+        {
+            std::ostringstream name;
+            name<<"joint_"<<i + 1;
+            joint_names.push_back(name.str());
+        }
+        registerJoints(joint_names);
+    }
+
+    /**Creates one joint per name.*/
+    explicit FakeJointHardware(const std::vector<std::string>& joint_names)
+    {
+        registerJoints(joint_names);
+    }
+
+    std::vector<std::string> joint_names_;
+    std::vector<double> position_;
+    std::vector<double> velocity_;
+    std::vector<double> effort_;
+    std::vector<double> command_; ///< efforts or velocities, depending on the interface the controller claimed
+
+    //**Joint model used by simulate(...), each joint is an independent rigid body driven by its effort.*/
+    std::vector<double> inertia_; ///< in kg m^2, including the reflected rotor inertia
+    std::vector<double> damping_; ///< viscous friction in Nm s/rad
+    std::vector<double> friction_; ///< Coulomb friction in Nm
+    std::vector<double> effort_limit_; ///< the commanded efforts are clamped to +-effort_limit_
+
+    /**Advances all joints by dt with the commands as efforts: inertia*dv/dt = effort - damping*v - friction*tanh(v/0.01),
+       integrated with the semi-implicit Euler method. The applied (clamped) efforts are stored in effort_.*/
+    void simulate(double dt)
+    {
+        for(unsigned int i=0; i<command_.size(); i++)
+        {
+            effort_[i] = std::max(-effort_limit_[i], std::min(command_[i], effort_limit_[i]));
+            double acceleration = (effort_[i] - damping_[i] * velocity_[i] - friction_[i] * std::tanh(velocity_[i] / 0.01)) / inertia_[i];
+            velocity_[i] += acceleration * dt;
+            position_[i] += velocity_[i] * dt;
+        }
+    }
+
+    hardware_interface::JointStateInterface state_interface_;
+    hardware_interface::EffortJointInterface effort_interface_;
+    hardware_interface::VelocityJointInterface velocity_interface_;
+
+    /**The interface of the given type, for controllers templated on it.*/
+    template <class HardwareInterface>
+    HardwareInterface* getInterface();
+
+private:
+
+    /**Allocates the states once, the handles point into them.*/
+    void registerJoints(const std::vector<std::string>& joint_names)
+    {
+        unsigned int n_joints = joint_names.size();
+        joint_names_ = joint_names;
+        position_.assign(n_joints, 0.0);
+        velocity_.assign(n_joints, 0.0);
+        effort_.assign(n_joints, 0.0);
+        command_.assign(n_joints, 0.0);
+        inertia_.assign(n_joints, 1.0);
+        damping_.assign(n_joints, 0.0);
+        friction_.assign(n_joints, 0.0);
+        effort_limit_.assign(n_joints, std::numeric_limits<double>::infinity());
+
+        for(unsigned int i=0; i<n_joints; i++)
+        {
+            hardware_interface::JointStateHandle state(joint_names_[i], &position_[i], &velocity_[i], &effort_[i]);
+            state_interface_.registerHandle(state);
+            effort_interface_.registerHandle(hardware_interface::JointHandle(state, &command_[i]));
+            velocity_interface_.registerHandle(hardware_interface::JointHandle(state, &command_[i]));
+        }
+    }
+};
+
+template <>
+inline hardware_interface::EffortJointInterface* FakeJointHardware::getInterface<hardware_interface::EffortJointInterface>() { return &effort_interface_; }
+
+template <>
+inline hardware_interface::VelocityJointInterface* FakeJointHardware::getInterface<hardware_interface::VelocityJointInterface>() { return &velocity_interface_; }
+
+//--------------------------------------------------------
+/**Sets the joints parameter of a JointGroupVelocityController in n and the same gains pid_<joint> for all joints.*/
+inline void setJointGroupParams(const ros::NodeHandle& n, const std::vector<std::string>& joint_names, double p, double i, double d, double i_clamp)
+{
+    n.setParam("joints", joint_names);
+    for(unsigned int j=0; j<joint_names.size(); j++)
+    {
+        ros::NodeHandle pid_n(n, "pid_" + joint_names[j]);
+        pid_n.setParam("p", p);
+        pid_n.setParam("i", i);
+        pid_n.setParam("d", d);
+        pid_n.setParam("i_clamp", i_clamp);
+    }
+}
+
+} //end namespace group_effort_controllers
+
+#endif
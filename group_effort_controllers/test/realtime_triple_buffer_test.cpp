@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <time.h>
+#include <Eigen/Core>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <group_effort_controllers/realtime_triple_buffer.h>
+
+using namespace group_effort_controllers;
+
+#define N_VALUES 64 //values per slot, large enough that a torn copy would mix sequence numbers
+#define N_WRITES 2000000
+#define LATENCY_BIN_NS 100 //width of the reader latency histogram bins
+#define N_LATENCY_BINS 1000 //the last bin also counts all larger latencies
+#define MAX_P999_LATENCY_NS 10000 //bound on the 99.9th percentile of the reader latency
+//--------------------------------------------------------
+/**
+   * \brief Shared state of a writer/reader stress run.
+   *
+   * Every published slot holds N_VALUES copies of its sequence number. Writers draw increasing sequence numbers under
+   * the writer lock and count one as published only after publish() returned, so the reader knows the value it must not
+   * fall behind of.
+   */
+struct StressState
+{
+    StressState() : next_(0), published_(0), done_(false) {}
+
+    RealtimeTripleBuffer<Eigen::VectorXd> buffer_;
+    boost::mutex writer_lock_; ///< serializes several writers, as the command callbacks do
+    boost::uint64_t next_; ///< last sequence number drawn by a writer
+    boost::atomic<boost::uint64_t> published_; ///< latest sequence number whose publish() returned
+    boost::atomic<bool> done_;
+};
+//--------------------------------------------------------
+void write(StressState* state, unsigned int n_writes)
+{
+    for(unsigned int k=0; k<n_writes; k++)
+    {
+        boost::mutex::scoped_lock lock(state->writer_lock_);
+        boost::uint64_t seq = ++state->next_;
+        state->buffer_.back().setConstant((double)seq);
+        state->buffer_.publish();
+        state->published_.store(seq, boost::memory_order_release);
+    }
+}
+//--------------------------------------------------------
+static long long nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+//--------------------------------------------------------
+struct ReadResult
+{
+    ReadResult() : reads_(0), updates_(0), torn_(0), stale_(0), last_(0), latency_max_ns_(0), latency_histogram_(N_LATENCY_BINS, 0) {}
+
+    /**Upper edge of the first histogram bin at which the cumulated count reaches the percentile p, in ns.*/
+    long long latencyPercentileNs(double p) const
+    {
+        boost::uint64_t sum = 0;
+        for(unsigned int i=0; i<latency_histogram_.size(); i++)
+        {
+            sum += latency_histogram_[i];
+            if(sum >= p * reads_)
+                return (i + 1) * (long long)LATENCY_BIN_NS;
+        }
+        return latency_histogram_.size() * (long long)LATENCY_BIN_NS;
+    }
+
+    boost::uint64_t reads_;
+    boost::uint64_t updates_;
+    boost::uint64_t torn_; ///< slots holding more than one sequence number
+    boost::uint64_t stale_; ///< reads older than a value the reader saw before or than the latest published value
+    boost::uint64_t last_;
+    //**Time the reader needs per cycle for update() and reading front(), which must not depend on the writers.*/
+    long long latency_max_ns_;
+    std::vector<boost::uint64_t> latency_histogram_;
+};
+//--------------------------------------------------------
+void read(StressState* state, ReadResult* result)
+{
+    bool done = false;
+    while(!done)
+    {
+        //read the flag first, so that the last round sees the final value
+        done = state->done_.load(boost::memory_order_acquire);
+        boost::uint64_t published = state->published_.load(boost::memory_order_acquire);
+
+        //the reader side of a control cycle, as in JointGroupVelocityController::update()
+        long long start = nowNs();
+        bool updated = state->buffer_.update();
+        const Eigen::VectorXd& value = state->buffer_.front();
+        boost::uint64_t seq = (boost::uint64_t)value(0);
+        bool torn = (value.array() != value(0)).any();
+        long long latency = nowNs() - start;
+
+        result->latency_max_ns_ = std::max(result->latency_max_ns_, latency);
+        result->latency_histogram_[std::min(latency / LATENCY_BIN_NS, (long long)N_LATENCY_BINS - 1)]++;
+        if(updated)
+            result->updates_++;
+        if(torn)
+            result->torn_++;
+        if(seq < result->last_ || seq < published)
+            result->stale_++;
+
+        result->last_ = std::max(result->last_, seq);
+        result->reads_++;
+    }
+}
+//--------------------------------------------------------
+/**
+   * The reader never waits for a writer, so its latency must stay bounded however hard the writers publish. The
+   * maximum also contains the times the reader thread was preempted (e.g., by the writers on a single core) and is
+   * only reported, the bound is checked on the 99.9th percentile.
+   */
+void expectBoundedLatency(const ReadResult& result)
+{
+    std::cout << "reader latency over " << result.reads_ << " reads: p50 " << result.latencyPercentileNs(0.5) << " ns, p99.9 "
+              << result.latencyPercentileNs(0.999) << " ns, max " << result.latency_max_ns_ << " ns" << std::endl;
+    EXPECT_LE(result.latencyPercentileNs(0.999), MAX_P999_LATENCY_NS);
+}
+//--------------------------------------------------------
+TEST(RealtimeTripleBuffer, OneWriterOneReader)
+{
+    StressState state;
+    state.buffer_.initialize(Eigen::VectorXd::Zero(N_VALUES));
+    ReadResult result;
+
+    boost::thread reader(boost::bind(&read, &state, &result));
+    boost::thread writer(boost::bind(&write, &state, N_WRITES));
+    writer.join();
+    state.done_.store(true, boost::memory_order_release);
+    reader.join();
+
+    EXPECT_EQ(0u, result.torn_);
+    EXPECT_EQ(0u, result.stale_);
+    EXPECT_EQ((boost::uint64_t)N_WRITES, result.last_);
+    EXPECT_GT(result.updates_, 0u);
+    expectBoundedLatency(result);
+}
+//--------------------------------------------------------
+TEST(RealtimeTripleBuffer, SerializedWritersOneReader)
+{
+    StressState state;
+    state.buffer_.initialize(Eigen::VectorXd::Zero(N_VALUES));
+    ReadResult result;
+
+    boost::thread reader(boost::bind(&read, &state, &result));
+    boost::thread_group writers;
+    for(unsigned int w=0; w<4; w++)
+        writers.create_thread(boost::bind(&write, &state, N_WRITES / 4));
+    writers.join_all();
+    state.done_.store(true, boost::memory_order_release);
+    reader.join();
+
+    EXPECT_EQ(0u, result.torn_);
+    EXPECT_EQ(0u, result.stale_);
+    EXPECT_EQ((boost::uint64_t)N_WRITES, result.last_);
+    EXPECT_GT(result.updates_, 0u);
+    expectBoundedLatency(result);
+}
+//--------------------------------------------------------
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
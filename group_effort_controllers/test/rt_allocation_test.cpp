@@ -0,0 +1,223 @@
+/**Checks that JointGroupVelocityController::update() and the command callbacks setCommandCB(...),
+ * setGroupCommandCB(...) and setTrajectoryCommandCB(...) don't call malloc, free or any other heap function after
+ * starting(), with all controller variants and optional features, while commands arrive on all command topics and the
+ * state is published. allocation_counter.cpp interposes the heap functions, so Eigen, the STL, ROS and the realtime
+ * publishers are all covered.*/
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <std_msgs/Float64.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <trajectory_msgs/JointTrajectory.h>
+#include <group_effort_controllers/joint_group_velocity_controller.h>
+#include <cmath>
+#include <unistd.h>
+#include "fake_joint_hardware.h"
+#include "allocation_counter.h"
+
+using namespace group_effort_controllers;
+
+#define CONTROL_PERIOD 0.001
+#define START_TIME 100.0 //simulated time in s at which the controller is started
+#define N_CYCLES 2000 //the state is published every 20 cycles
+#define COMMAND_INTERVAL 10 //cycles between two command messages
+
+//---------------------------------------------------------------------
+/**Sets the joints and gains of a controller with n_joints joints in the sub-namespace name of the test node's private namespace and returns it.*/
+ros::NodeHandle setUpNamespace(const std::string& name, unsigned int n_joints)
+{
+    ros::NodeHandle n("~/" + name);
+    setJointGroupParams(n, FakeJointHardware(n_joints).joint_names_, 100.0, 10.0, 0.1, 100.0);
+    n.setParam("statistics/publish_rate", 0.0);
+    return n;
+}
+//---------------------------------------------------------------------
+/**Heap calls counted in update() and in each command callback.*/
+struct AllocationCounts
+{
+    AllocationCounts() : update_(0), command_(0), group_command_(0), trajectory_command_(0) {}
+
+    unsigned long update_;
+    unsigned long command_;
+    unsigned long group_command_;
+    unsigned long trajectory_command_;
+};
+//---------------------------------------------------------------------
+/**
+   * Starts the controller on fake hardware and runs it for N_CYCLES cycles with varying joint states. Between the
+   * cycles, commands are published in turn on the group, trajectory and - if legacy_command_topics is set - per-joint
+   * command topics, the callbacks run concurrently in the spinner thread. Each command is also passed directly to its
+   * callback on the test thread, where the heap calls of the callback are counted. The messages for the direct calls
+   * are allocated once up front, as the subscription would deliver them.
+   */
+template <int N, class HardwareInterface>
+AllocationCounts countAllocations(const ros::NodeHandle& n, unsigned int n_joints)
+{
+    AllocationCounts counts;
+    FakeJointHardware hw(n_joints);
+    GenericJointGroupVelocityController<N, HardwareInterface> controller;
+    ros::NodeHandle controller_n(n);
+    if(!controller.init(hw.getInterface<HardwareInterface>(), controller_n))
+    {
+        ADD_FAILURE() << "could not initialize the controller in " << n.getNamespace();
+        return counts;
+    }
+
+    ros::Publisher group_pub = n.advertise<std_msgs::Float64MultiArray>("command", 1);
+    ros::Publisher trajectory_pub = n.advertise<trajectory_msgs::JointTrajectory>("command_trajectory", 1);
+    std::vector<ros::Publisher> joint_pubs;
+    if(n.param("legacy_command_topics", false))
+        for(unsigned int i=0; i<n_joints; i++)
+            joint_pubs.push_back(n.advertise<std_msgs::Float64>(hw.joint_names_[i] + "/command", 1));
+
+    ros::Time time(START_TIME);
+    ros::Duration period(CONTROL_PERIOD);
+    controller.starting(time);
+
+    std_msgs::Float64MultiArrayPtr group_msg(new std_msgs::Float64MultiArray);
+    group_msg->data.resize(n_joints);
+    //named joints in reverse order, so that the callback has to map them
+    trajectory_msgs::JointTrajectoryPtr trajectory_msg(new trajectory_msgs::JointTrajectory);
+    trajectory_msg->joint_names.assign(hw.joint_names_.rbegin(), hw.joint_names_.rend());
+    trajectory_msg->points.resize(3);
+    for(unsigned int k=0; k<trajectory_msg->points.size(); k++)
+    {
+        trajectory_msg->points[k].time_from_start = ros::Duration(k * 2 * COMMAND_INTERVAL * CONTROL_PERIOD);
+        trajectory_msg->points[k].velocities.resize(n_joints);
+    }
+    std_msgs::Float64Ptr joint_msg(new std_msgs::Float64);
+    //converted once, the callbacks take const pointers
+    std_msgs::Float64MultiArrayConstPtr group_cmsg = group_msg;
+    trajectory_msgs::JointTrajectoryConstPtr trajectory_cmsg = trajectory_msg;
+    std_msgs::Float64ConstPtr joint_cmsg = joint_msg;
+
+    for(unsigned int k=0; k<N_CYCLES; k++)
+    {
+        //publishing allocates, so it is done outside of the counted sections
+        if(k % COMMAND_INTERVAL == 0)
+        {
+            unsigned int turn = (k / COMMAND_INTERVAL) % 3;
+            double value = 0.1 * std::sin(1e-2 * k);
+            if(turn == 0)
+            {
+                for(unsigned int i=0; i<n_joints; i++)
+                    group_msg->data[i] = value;
+                group_pub.publish(*group_msg);
+
+                allocation_counter::start();
+                controller.setGroupCommandCB(group_cmsg, 0, n_joints);
+                counts.group_command_ += allocation_counter::stop();
+            }
+            else if(turn == 1)
+            {
+                trajectory_msg->header.stamp = time;
+                for(unsigned int p=0; p<trajectory_msg->points.size(); p++)
+                    for(unsigned int i=0; i<n_joints; i++)
+                        trajectory_msg->points[p].velocities[i] = value + 0.01 * p;
+                trajectory_pub.publish(*trajectory_msg);
+
+                allocation_counter::start();
+                controller.setTrajectoryCommandCB(trajectory_cmsg);
+                counts.trajectory_command_ += allocation_counter::stop();
+            }
+            else
+            {
+                unsigned int i = (k / COMMAND_INTERVAL) % n_joints;
+                joint_msg->data = value;
+                if(!joint_pubs.empty())
+                    joint_pubs[i].publish(*joint_msg);
+
+                allocation_counter::start();
+                controller.setCommandCB(joint_cmsg, i);
+                counts.command_ += allocation_counter::stop();
+            }
+        }
+
+        for(unsigned int i=0; i<n_joints; i++)
+        {
+            hw.velocity_[i] = 0.1 * std::sin(1e-3 * k + i);
+            hw.position_[i] += hw.velocity_[i] * CONTROL_PERIOD;
+            hw.effort_[i] = hw.command_[i];
+        }
+        time += period;
+
+        allocation_counter::start();
+        controller.update(time, period);
+        counts.update_ += allocation_counter::stop();
+
+        //gives the spinner thread time to deliver the commands
+        if(k % COMMAND_INTERVAL == 0)
+            usleep(1000);
+    }
+
+    return counts;
+}
+//---------------------------------------------------------------------
+/**Expects no heap calls in update() and all command callbacks.*/
+void expectNoAllocations(const AllocationCounts& counts)
+{
+    EXPECT_EQ(0u, counts.update_) << "heap calls in update()";
+    EXPECT_EQ(0u, counts.command_) << "heap calls in setCommandCB(...)";
+    EXPECT_EQ(0u, counts.group_command_) << "heap calls in setGroupCommandCB(...)";
+    EXPECT_EQ(0u, counts.trajectory_command_) << "heap calls in setTrajectoryCommandCB(...)";
+}
+//---------------------------------------------------------------------
+TEST(RtAllocation, DynamicController)
+{
+    ros::NodeHandle n = setUpNamespace("dynamic", 7);
+    n.setParam("legacy_command_topics", true);
+    expectNoAllocations(countAllocations<Eigen::Dynamic, hardware_interface::EffortJointInterface>(n, 7));
+}
+//---------------------------------------------------------------------
+TEST(RtAllocation, FixedSizeControllers)
+{
+    ros::NodeHandle n7 = setUpNamespace("fixed_7", 7);
+    expectNoAllocations(countAllocations<7, hardware_interface::EffortJointInterface>(n7, 7));
+    ros::NodeHandle n8 = setUpNamespace("fixed_8", 8);
+    expectNoAllocations(countAllocations<8, hardware_interface::EffortJointInterface>(n8, 8));
+}
+//---------------------------------------------------------------------
+TEST(RtAllocation, PassthroughController)
+{
+    ros::NodeHandle n = setUpNamespace("passthrough", 7);
+    expectNoAllocations(countAllocations<Eigen::Dynamic, hardware_interface::VelocityJointInterface>(n, 7));
+}
+//---------------------------------------------------------------------
+TEST(RtAllocation, OptionalFeatures)
+{
+    ros::NodeHandle n = setUpNamespace("features", 3);
+    n.setParam("velocity_filter/type", std::string("butterworth"));
+    n.setParam("disturbance_observer/enabled", true);
+    n.setParam("disturbance_observer/inertia", std::vector<double>(3, 0.5));
+    n.setParam("disturbance_observer/max_compensation", 10.0);
+    n.setParam("gain_schedule/keys", std::vector<std::string>(1, "joint_2"));
+    n.setParam("gain_schedule/min", std::vector<double>(1, -1.0));
+    n.setParam("gain_schedule/max", std::vector<double>(1, 1.0));
+    n.setParam("gain_schedule/n_points", std::vector<int>(1, 3));
+    n.setParam("gain_schedule/factors/joint_1", std::vector<double>(3, 0.8));
+    n.setParam("bumpless/integrator_seed", std::string("effort"));
+    n.setParam("bumpless/command_ramp", 0.1);
+    n.setParam("telemetry/output", std::string("topic"));
+    n.setParam("flight_recorder/file_name", std::string("/tmp/rt_allocation_test.bin"));
+    expectNoAllocations(countAllocations<Eigen::Dynamic, hardware_interface::EffortJointInterface>(n, 3));
+}
+//---------------------------------------------------------------------
+TEST(RtAllocation, TelemetryFile)
+{
+    ros::NodeHandle n = setUpNamespace("telemetry_file", 7);
+    n.setParam("telemetry/output", std::string("file"));
+    n.setParam("telemetry/file_name", std::string("/tmp/rt_allocation_test_telemetry.bin"));
+    expectNoAllocations(countAllocations<Eigen::Dynamic, hardware_interface::EffortJointInterface>(n, 7));
+}
+//---------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    ros::init(argc, argv, "rt_allocation_test");
+
+    //delivers the commands concurrently to update(), as the controller manager's spinner does
+    ros::AsyncSpinner spinner(1);
+    spinner.start();
+    int result = RUN_ALL_TESTS();
+    spinner.stop();
+    return result;
+}
@@ -0,0 +1,366 @@
+/**Runs JointGroupVelocityController::update() on fake hardware and reports the execution time per cycle, the heap calls
+ * and the cache misses. It also compares the GroupPid kernel against the former loop over one control_toolbox::Pid per
+ * joint. The parameters are set on the parameter server, so a roscore has to be running:
+ * rosrun group_effort_controllers update_benchmark [<cycles>]*/
+#include <ros/ros.h>
+#include <group_effort_controllers/joint_group_velocity_controller.h>
+#include <group_effort_controllers/group_pid.h>
+#include <control_toolbox/pid.h>
+#include <std_msgs/Float64.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <boost/thread/thread.hpp>
+#include <boost/atomic.hpp>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include "fake_joint_hardware.h"
+#include "allocation_counter.h"
+
+using namespace group_effort_controllers;
+
+#define WARMUP_CYCLES 1000
+#define CONTROL_PERIOD 0.001
+#define KERNEL_BATCH 100 //PID kernel calls per time measurement, a single call is too short for clock_gettime
+#define N_ERRORS 1024 //rows of precomputed velocity errors the PID kernels cycle through
+
+//---------------------------------------------------------------------
+/**Variants of the controller setup, each one is run on a fresh controller.*/
+enum Variant
+{
+    BASELINE, ///< constant zero commands, state publisher at its default rate, everything optional disabled
+    NO_PUBLISH, ///< as BASELINE, but with publish_rate: 0, i.e., without the state publisher
+    TELEMETRY, ///< telemetry/output: topic, i.e., one record per cycle into the ring buffer
+    CONTENTION ///< command and per-joint command topics written at 1 kHz each while update() runs
+};
+//---------------------------------------------------------------------
+struct BenchmarkResult
+{
+    std::vector<double> times_; ///< execution time per cycle of each measurement in ns
+    unsigned long allocations_;
+    unsigned long cycles_; ///< number of cycles the allocations and cache misses were counted over
+    long long cache_misses_; ///< -1 if the counter isn't available
+};
+//---------------------------------------------------------------------
+static long long nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+//---------------------------------------------------------------------
+/**Hardware cache miss counter of the calling thread (user space only), -1 if perf events aren't permitted.*/
+static int openCacheMissCounter()
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+//---------------------------------------------------------------------
+static void startCacheMissCounter(int counter)
+{
+    if(counter < 0)
+        return;
+
+    ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+    ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+}
+//---------------------------------------------------------------------
+/**Stops and closes the counter, returns the cache misses since startCacheMissCounter(...) or -1.*/
+static long long closeCacheMissCounter(int counter)
+{
+    if(counter < 0)
+        return -1;
+
+    long long cache_misses = -1;
+    ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+    if(read(counter, &cache_misses, sizeof(cache_misses)) != sizeof(cache_misses))
+        cache_misses = -1;
+    close(counter);
+    return cache_misses;
+}
+//---------------------------------------------------------------------
+/**Publishes all joint commands on the group topic and on the per-joint topics at about 1 kHz until stopped.*/
+static void publishCommands(ros::NodeHandle n, std::vector<std::string> joint_names, boost::atomic<bool>* stop)
+{
+    ros::Publisher group_pub = n.advertise<std_msgs::Float64MultiArray>("command", 1);
+    std::vector<ros::Publisher> joint_pubs;
+    for(unsigned int i=0; i<joint_names.size(); i++)
+        joint_pubs.push_back(n.advertise<std_msgs::Float64>(joint_names[i] + "/command", 1));
+
+    std_msgs::Float64MultiArray group_msg;
+    group_msg.data.resize(joint_names.size(), 0.1);
+    std_msgs::Float64 joint_msg;
+    joint_msg.data = 0.1;
+    while(!stop->load())
+    {
+        group_pub.publish(group_msg);
+        for(unsigned int i=0; i<joint_pubs.size(); i++)
+            joint_pubs[i].publish(joint_msg);
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+}
+//---------------------------------------------------------------------
+template <int N>
+static bool runBenchmark(Variant variant, unsigned int n_joints, unsigned int n_cycles, const std::string& name, BenchmarkResult& result)
+{
+    FakeJointHardware hw(n_joints);
+    ros::NodeHandle n("~/" + name);
+    setJointGroupParams(n, hw.joint_names_, 100.0, 10.0, 0.1, 100.0);
+    n.setParam("statistics/publish_rate", 0.0);
+    n.setParam("publish_rate", variant == NO_PUBLISH ? 0.0 : (double)PUBLISH_RATE);
+    n.setParam("telemetry/output", std::string(variant == TELEMETRY ? "topic" : ""));
+    n.setParam("legacy_command_topics", variant == CONTENTION);
+
+    GenericJointGroupVelocityController<N> controller;
+    if(!controller.init(&hw.effort_interface_, n))
+        return false;
+
+    boost::atomic<bool> stop(false);
+    boost::thread publisher;
+    if(variant == CONTENTION)
+        publisher = boost::thread(&publishCommands, n, hw.joint_names_, &stop);
+
+    ros::Time time = ros::Time::now();
+    ros::Duration period(CONTROL_PERIOD);
+    controller.starting(time);
+
+    result.times_.resize(n_cycles);
+    result.allocations_ = 0;
+    result.cycles_ = n_cycles;
+    int counter = openCacheMissCounter();
+    for(unsigned int k=0; k<WARMUP_CYCLES + n_cycles; k++)
+    {
+        //slowly varying joint states, so that the computations don't run on constant data
+        for(unsigned int i=0; i<n_joints; i++)
+        {
+            hw.velocity_[i] = 0.1 * std::sin(1e-3 * k + i);
+            hw.position_[i] += hw.velocity_[i] * CONTROL_PERIOD;
+            hw.effort_[i] = hw.command_[i];
+        }
+        time += period;
+
+        if(k == WARMUP_CYCLES)
+            startCacheMissCounter(counter);
+
+        allocation_counter::start();
+        long long start = nowNs();
+        controller.update(time, period);
+        long long duration = nowNs() - start;
+        unsigned long allocations = allocation_counter::stop();
+
+        if(k >= WARMUP_CYCLES)
+        {
+            result.times_[k - WARMUP_CYCLES] = duration;
+            result.allocations_ += allocations;
+        }
+    }
+
+    result.cache_misses_ = closeCacheMissCounter(counter);
+
+    stop.store(true);
+    if(publisher.joinable())
+        publisher.join();
+
+    return true;
+}
+//---------------------------------------------------------------------
+/**Velocity errors which vary from cycle to cycle, so that the PID kernels don't run on constant data.*/
+static Eigen::MatrixXd makeErrors(unsigned int n_joints)
+{
+    Eigen::MatrixXd errors(n_joints, N_ERRORS);
+    for(unsigned int k=0; k<N_ERRORS; k++)
+        for(unsigned int i=0; i<n_joints; i++)
+            errors(i, k) = 0.1 * std::sin(1e-2 * k + i);
+
+    return errors;
+}
+//---------------------------------------------------------------------
+/**Measures GroupPid<N>::computeCommand(...) for all joints, in batches of KERNEL_BATCH calls.*/
+template <int N>
+static bool runGroupPidBenchmark(unsigned int n_joints, unsigned int n_cycles, const std::string& name, BenchmarkResult& result)
+{
+    FakeJointHardware hw(n_joints);
+    ros::NodeHandle n("~/" + name);
+    setJointGroupParams(n, hw.joint_names_, 100.0, 10.0, 0.1, 100.0);
+
+    GroupPid<N> pid;
+    if(!pid.init(n, hw.joint_names_))
+        return false;
+
+    Eigen::MatrixXd errors = makeErrors(n_joints);
+    Eigen::Array<double, N, 1> error(n_joints);
+    Eigen::Array<double, N, 1> efforts(n_joints);
+    unsigned int n_batches = std::max(n_cycles / KERNEL_BATCH, 1u);
+    result.times_.resize(n_batches);
+    result.allocations_ = 0;
+    result.cycles_ = n_batches * KERNEL_BATCH;
+    int counter = openCacheMissCounter();
+    startCacheMissCounter(counter);
+    for(unsigned int b=0; b<n_batches; b++)
+    {
+        allocation_counter::start();
+        long long start = nowNs();
+        for(unsigned int k=0; k<KERNEL_BATCH; k++)
+        {
+            error = errors.col((b * KERNEL_BATCH + k) % N_ERRORS).array();
+            efforts = pid.computeCommand(error, CONTROL_PERIOD);
+        }
+        long long duration = nowNs() - start;
+        result.allocations_ += allocation_counter::stop();
+        result.times_[b] = (double)duration / KERNEL_BATCH;
+    }
+    result.cache_misses_ = closeCacheMissCounter(counter);
+
+    //keeps the compiler from dropping the computation
+    if(!efforts.allFinite())
+        printf("non-finite efforts\n");
+
+    return true;
+}
+//---------------------------------------------------------------------
+/**Measures the loop over one control_toolbox::Pid per joint which GroupPid replaced, in batches of KERNEL_BATCH calls.*/
+static void runPidLoopBenchmark(unsigned int n_joints, unsigned int n_cycles, BenchmarkResult& result)
+{
+    std::vector<control_toolbox::Pid> pids(n_joints);
+    for(unsigned int i=0; i<n_joints; i++)
+        pids[i].initPid(100.0, 10.0, 0.1, 100.0, -100.0);
+
+    Eigen::MatrixXd errors = makeErrors(n_joints);
+    std::vector<double> efforts(n_joints);
+    ros::Duration period(CONTROL_PERIOD);
+    unsigned int n_batches = std::max(n_cycles / KERNEL_BATCH, 1u);
+    result.times_.resize(n_batches);
+    result.allocations_ = 0;
+    result.cycles_ = n_batches * KERNEL_BATCH;
+    int counter = openCacheMissCounter();
+    startCacheMissCounter(counter);
+    for(unsigned int b=0; b<n_batches; b++)
+    {
+        allocation_counter::start();
+        long long start = nowNs();
+        for(unsigned int k=0; k<KERNEL_BATCH; k++)
+        {
+            unsigned int col = (b * KERNEL_BATCH + k) % N_ERRORS;
+            for(unsigned int i=0; i<n_joints; i++)
+                efforts[i] = pids[i].computeCommand(errors(i, col), period);
+        }
+        long long duration = nowNs() - start;
+        result.allocations_ += allocation_counter::stop();
+        result.times_[b] = (double)duration / KERNEL_BATCH;
+    }
+    result.cache_misses_ = closeCacheMissCounter(counter);
+
+    for(unsigned int i=0; i<n_joints; i++)
+        if(!std::isfinite(efforts[i]))
+            printf("non-finite efforts\n");
+}
+//---------------------------------------------------------------------
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    unsigned int k = (unsigned int)std::ceil(p * sorted.size());
+    return sorted[std::min(std::max(k, 1u), (unsigned int)sorted.size()) - 1];
+}
+//---------------------------------------------------------------------
+static void printResult(const std::string& name, unsigned int n_joints, BenchmarkResult& result)
+{
+    std::sort(result.times_.begin(), result.times_.end());
+    double mean = 0.0;
+    for(unsigned int k=0; k<result.times_.size(); k++)
+        mean += result.times_[k] / result.times_.size();
+
+    printf("%-24s %6u %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f %12.3f", name.c_str(), n_joints, mean, percentile(result.times_, 0.5),
+           percentile(result.times_, 0.9), percentile(result.times_, 0.99), percentile(result.times_, 0.999), result.times_.back(),
+           (double)result.allocations_ / result.cycles_);
+    if(result.cache_misses_ >= 0)
+        printf(" %14.2f\n", (double)result.cache_misses_ / result.cycles_);
+    else
+        printf(" %14s\n", "n/a");
+}
+//---------------------------------------------------------------------
+/**Runs and prints one case, returns the median execution time or -1 if the controller couldn't be initialized.*/
+template <int N>
+static double benchmark(Variant variant, unsigned int n_joints, unsigned int n_cycles, const std::string& name)
+{
+    BenchmarkResult result;
+    if(!runBenchmark<N>(variant, n_joints, n_cycles, name, result))
+    {
+        printf("%-24s %6u could not initialize the controller\n", name.c_str(), n_joints);
+        return -1.0;
+    }
+    printResult(name, n_joints, result);
+    return percentile(result.times_, 0.5);
+}
+//---------------------------------------------------------------------
+template <int N>
+static void benchmarkGroupPid(unsigned int n_joints, unsigned int n_cycles, const std::string& name)
+{
+    BenchmarkResult result;
+    if(!runGroupPidBenchmark<N>(n_joints, n_cycles, name, result))
+    {
+        printf("%-24s %6u could not initialize the PID\n", name.c_str(), n_joints);
+        return;
+    }
+    printResult(name, n_joints, result);
+}
+//---------------------------------------------------------------------
+static void benchmarkPidLoop(unsigned int n_joints, unsigned int n_cycles, const std::string& name)
+{
+    BenchmarkResult result;
+    runPidLoopBenchmark(n_joints, n_cycles, result);
+    printResult(name, n_joints, result);
+}
+//---------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "update_benchmark");
+    unsigned int n_cycles = (argc > 1) ? atoi(argv[1]) : 100000;
+    if(n_cycles == 0)
+    {
+        fprintf(stderr, "Usage: %s [<cycles>]\n", argv[0]);
+        return 1;
+    }
+
+    //delivers the command callbacks concurrently to update(), as the controller manager's spinner does
+    ros::AsyncSpinner spinner(1);
+    spinner.start();
+
+    printf("%u cycles of update() per case, times in ns, heap calls (malloc, free, ...) and cache misses per cycle\n", n_cycles);
+    printf("%-24s %6s %10s %10s %10s %10s %10s %10s %12s %14s\n", "case", "joints", "mean", "p50", "p90", "p99", "p99.9", "max", "heap calls", "cache misses");
+    double dynamic_7 = benchmark<Eigen::Dynamic>(BASELINE, 7, n_cycles, "dynamic");
+    double fixed_7 = benchmark<7>(BASELINE, 7, n_cycles, "fixed_7");
+    double dynamic_8 = benchmark<Eigen::Dynamic>(BASELINE, 8, n_cycles, "dynamic_8");
+    double fixed_8 = benchmark<8>(BASELINE, 8, n_cycles, "fixed_8");
+    benchmark<Eigen::Dynamic>(BASELINE, 14, n_cycles, "dynamic_14");
+    benchmark<Eigen::Dynamic>(NO_PUBLISH, 7, n_cycles, "dynamic_no_publish");
+    benchmark<Eigen::Dynamic>(TELEMETRY, 7, n_cycles, "dynamic_telemetry");
+    benchmark<Eigen::Dynamic>(CONTENTION, 7, n_cycles, "dynamic_contention");
+    if(dynamic_7 > 0.0 && fixed_7 > 0.0 && dynamic_8 > 0.0 && fixed_8 > 0.0)
+        printf("p50 of the fixed-size controller relative to the dynamic one: %.2f with 7 joints, %.2f with 8 joints\n", fixed_7 / dynamic_7, fixed_8 / dynamic_8);
+
+    printf("\nPID kernel only, times per call of all joints measured over batches of %d calls\n", KERNEL_BATCH);
+    printf("%-24s %6s %10s %10s %10s %10s %10s %10s %12s %14s\n", "case", "joints", "mean", "p50", "p90", "p99", "p99.9", "max", "heap calls", "cache misses");
+    benchmarkPidLoop(7, n_cycles, "control_toolbox_pid_7");
+    benchmarkGroupPid<Eigen::Dynamic>(7, n_cycles, "group_pid_dynamic_7");
+    benchmarkGroupPid<7>(7, n_cycles, "group_pid_7");
+    benchmarkPidLoop(8, n_cycles, "control_toolbox_pid_8");
+    benchmarkGroupPid<Eigen::Dynamic>(8, n_cycles, "group_pid_dynamic_8");
+    benchmarkGroupPid<8>(8, n_cycles, "group_pid_8");
+    benchmarkPidLoop(14, n_cycles, "control_toolbox_pid_14");
+    benchmarkGroupPid<Eigen::Dynamic>(14, n_cycles, "group_pid_dynamic_14");
+    benchmarkGroupPid<14>(14, n_cycles, "group_pid_14");
+
+    ros::shutdown();
+    return 0;
+}